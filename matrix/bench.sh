@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# Usage: ./bench.sh [max_side] > results.json
+
+set -e
+
+g++ -std=c++17 -O3 -pthread -I./ bench/bench.cpp src/matrix.cpp src/gemm.cpp \
+    src/thread_pool.cpp src/factorization.cpp src/blas.cpp \
+    src/simd.cpp src/matrix_io.cpp src/instrumentation.cpp -o matrix_bench
+./matrix_bench "$@"
+
+rm matrix_bench
@@ -0,0 +1,220 @@
+// Throughput of the core Matrix operations over square and skinny shapes.
+// Results go to stdout as JSON, progress to stderr:
+//
+//   ./matrix_bench [max_side] > results.json
+//
+// max_side (default 4096) caps the largest square case; skinny cases with
+// more elements than max_side^2 are skipped as well.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/matrix.h"
+#include "src/thread_pool.h"
+
+namespace {
+
+using task::ConstMatrixView;
+using task::Matrix;
+
+// Runs are timed in batches of at least kMinBatchSeconds so that the clock
+// resolution does not matter, and batches repeat until a case has run for
+// kMinSeconds. The fastest batch is reported.
+const double kMinBatchSeconds = 1e-3;
+const double kMinSeconds = 0.2;
+
+// Text I/O of larger matrices takes hundreds of megabytes of buffers.
+const size_t kMaxTextElements = 1 << 22;
+
+struct Shape {
+  size_t rows;
+  size_t cols;
+};
+
+struct Result {
+  std::string operation;
+  Shape shape;
+  size_t runs;
+  double seconds;
+  double flops;
+  double bytes;
+};
+
+// Keeps the optimizer from dropping the work being timed.
+volatile double sink;
+
+Matrix randomMatrix(size_t rows, size_t cols) {
+  static std::mt19937 generator(2020);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  Matrix result(rows, cols);
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      result[i][j] = distribution(generator);
+    }
+  }
+  return result;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+template <class Body>
+double timeBatch(size_t runs, const Body& body) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < runs; ++i) {
+    body();
+  }
+  return secondsSince(start);
+}
+
+// flops and bytes are per run; either is 0 when it does not apply.
+template <class Body>
+Result measure(const std::string& operation, Shape shape, double flops,
+               double bytes, const Body& body) {
+  size_t batch = 1;
+  double elapsed = timeBatch(batch, body);
+  while (elapsed < kMinBatchSeconds) {
+    batch *= 2;
+    elapsed = timeBatch(batch, body);
+  }
+  Result result{operation, shape, batch, elapsed / batch, flops, bytes};
+  double total = elapsed;
+  while (total < kMinSeconds) {
+    elapsed = timeBatch(batch, body);
+    result.seconds = std::min(result.seconds, elapsed / batch);
+    result.runs += batch;
+    total += elapsed;
+  }
+  std::cerr << operation << " " << shape.rows << "x" << shape.cols << ": "
+            << result.seconds * 1e6 << " us\n";
+  return result;
+}
+
+void benchmarkShape(Shape shape, std::vector<Result>& results) {
+  size_t rows = shape.rows;
+  size_t cols = shape.cols;
+  double elements = double(rows) * cols;
+  double matrix_bytes = elements * sizeof(double);
+  Matrix a = randomMatrix(rows, cols);
+  Matrix b = randomMatrix(rows, cols);
+
+  results.push_back(measure("construct", shape, 0, matrix_bytes, [&] {
+    Matrix c(rows, cols);
+    sink = c[0][0];
+  }));
+  results.push_back(measure("copy", shape, 0, 2 * matrix_bytes, [&] {
+    Matrix c = a;
+    sink = c[0][0];
+  }));
+  results.push_back(measure("add", shape, elements, 3 * matrix_bytes, [&] {
+    Matrix c = a + b;
+    sink = c[0][0];
+  }));
+
+  // Skinny operands are multiplied by their own transpose, which keeps the
+  // product small: outer x inner times inner x outer.
+  double outer = std::min(rows, cols);
+  double inner = std::max(rows, cols);
+  double product_bytes = (2 * elements + outer * outer) * sizeof(double);
+  results.push_back(measure(
+      "multiply", shape, 2 * outer * outer * inner, product_bytes, [&] {
+        Matrix c = rows == cols ? a * b
+                   : rows > cols
+                       ? Matrix(ConstMatrixView(a).transposed() * a)
+                       : Matrix(a * ConstMatrixView(a).transposed());
+        sink = c[0][0];
+      }));
+
+  Matrix transposed = a;
+  results.push_back(measure("transpose", shape, 0, 2 * matrix_bytes, [&] {
+    transposed.transpose();
+    sink = transposed[0][0];
+  }));
+  if (rows == cols) {
+    double n = rows;
+    results.push_back(measure("det", shape, 2.0 / 3 * n * n * n, 0,
+                              [&] { sink = a.det(); }));
+  }
+
+  // Alternates between growing by one row and column and shrinking back.
+  Matrix resized = a;
+  bool grow = true;
+  results.push_back(measure("resize", shape, 0, 2 * matrix_bytes, [&] {
+    resized.resize(rows + grow, cols + grow);
+    grow = !grow;
+    sink = resized[0][0];
+  }));
+
+  if (elements > kMaxTextElements) return;
+  std::ostringstream text;
+  text << rows << " " << cols << "\n" << a;
+  std::string written = text.str();
+  results.push_back(measure("write", shape, 0, written.size(), [&] {
+    std::ostringstream output;
+    output << a;
+    sink = output.tellp();
+  }));
+  std::istringstream input(written);
+  Matrix read;
+  results.push_back(measure("read", shape, 0, written.size(), [&] {
+    input.clear();
+    input.seekg(0);
+    input >> read;
+    sink = read[0][0];
+  }));
+}
+
+void printJson(const std::vector<Result>& results) {
+  std::cout << "{\n  \"threads\": "
+            << task::ThreadPool::instance().getThreadCount()
+            << ",\n  \"compiler\": \"" << __VERSION__ << "\",\n"
+            << "  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& result = results[i];
+    std::cout << "    {\"operation\": \"" << result.operation
+              << "\", \"rows\": " << result.shape.rows
+              << ", \"cols\": " << result.shape.cols
+              << ", \"runs\": " << result.runs
+              << ", \"seconds\": " << result.seconds;
+    if (result.flops > 0) {
+      std::cout << ", \"gflops\": " << result.flops / result.seconds / 1e9;
+    }
+    if (result.bytes > 0) {
+      std::cout << ", \"gbps\": " << result.bytes / result.seconds / 1e9;
+    }
+    std::cout << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  std::cout << "  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t max_side = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+  std::vector<Shape> shapes;
+  for (size_t side = 1; side <= max_side; side *= 4) {
+    shapes.push_back({side, side});
+  }
+  for (Shape shape : {Shape{1 << 16, 4}, Shape{1 << 14, 64},
+                      Shape{64, 1 << 14}, Shape{4, 1 << 16}}) {
+    if (shape.rows * shape.cols <= max_side * max_side) {
+      shapes.push_back(shape);
+    }
+  }
+
+  std::vector<Result> results;
+  for (Shape shape : shapes) {
+    benchmarkShape(shape, results);
+  }
+  printJson(results);
+  return 0;
+}
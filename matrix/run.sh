@@ -4,9 +4,17 @@ set -e
 
 STRESS_TEST_COUNT=500
 
-g++ -std=c++17 -I./ test/test.cpp src/matrix.cpp -o matrix_test
+SOURCES="test/test.cpp src/matrix.cpp src/gemm.cpp src/thread_pool.cpp \
+    src/factorization.cpp src/blas.cpp src/simd.cpp src/matrix_io.cpp \
+    src/sparse_matrix.cpp src/strassen.cpp src/instrumentation.cpp \
+    src/structured_matrix.cpp"
+
+g++ -std=c++17 -O3 -pthread -I./ $SOURCES -o matrix_test
+g++ -std=c++17 -O3 -pthread -I./ -DMATRIX_COPY_ON_WRITE $SOURCES \
+    -o matrix_test_cow
 python3 test/generate.py $STRESS_TEST_COUNT > test_data
 ./matrix_test $STRESS_TEST_COUNT < test_data
+./matrix_test_cow $STRESS_TEST_COUNT < test_data
 
 rm test_data
 
@@ -0,0 +1,62 @@
+#include "blas.h"
+
+#include "gemm.h"
+
+namespace task {
+
+namespace {
+
+const double* lastElement(const double* data, size_t rows, size_t cols,
+                          size_t row_stride, size_t col_stride) {
+  return data + (rows - 1) * row_stride + (cols - 1) * col_stride;
+}
+
+bool overlaps(const ConstMatrixView& a, const MatrixView& c) {
+  if (a.getRowSize() == 0 || a.getColSize() == 0 || c.getRowSize() == 0 ||
+      c.getColSize() == 0) {
+    return false;
+  }
+  const double* a_last = lastElement(a.data(), a.getRowSize(), a.getColSize(),
+                                     a.getRowStride(), a.getColStride());
+  const double* c_last = lastElement(c.data(), c.getRowSize(), c.getColSize(),
+                                     c.getRowStride(), c.getColStride());
+  return a.data() <= c_last && c.data() <= a_last;
+}
+
+}  // namespace
+
+void gemm(double alpha, const ConstMatrixView& a, const ConstMatrixView& b,
+          double beta, const MatrixView& c, Transpose trans_a,
+          Transpose trans_b) {
+  ConstMatrixView op_a = trans_a == Transpose::kTranspose ? a.transposed() : a;
+  ConstMatrixView op_b = trans_b == Transpose::kTranspose ? b.transposed() : b;
+  if (op_a.getColSize() != op_b.getRowSize() ||
+      c.getRowSize() != op_a.getRowSize() ||
+      c.getColSize() != op_b.getColSize()) {
+    throw SizeMismatchException();
+  }
+  MatrixView target = c;
+  if (c.getColStride() != 1 || overlaps(op_a, c) || overlaps(op_b, c)) {
+    Matrix product = multiply(op_a, op_b);
+    if (beta == 0.0) {
+      target = product * alpha;
+    } else {
+      target *= beta;
+      target += product * alpha;
+    }
+    return;
+  }
+  gemm(op_a.getRowSize(), op_b.getColSize(), op_a.getColSize(), alpha,
+       op_a.data(), op_a.getRowStride(), op_a.getColStride(), op_b.data(),
+       op_b.getRowStride(), op_b.getColStride(), beta, c.data(),
+       c.getRowStride());
+}
+
+void axpy(double alpha, const Matrix& x, Matrix& y) {
+  checkSameSize(x, y);
+  simd::axpy(y.getRowSize() * y.getColSize(), alpha, x[0], y[0]);
+}
+
+void scal(double alpha, Matrix& x) { x *= alpha; }
+
+}  // namespace task
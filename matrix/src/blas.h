@@ -0,0 +1,24 @@
+#pragma once
+
+#include "matrix.h"
+
+namespace task {
+
+enum class Transpose { kNone, kTranspose };
+
+// C = alpha * op(A) * op(B) + beta * C, where op() transposes its operand
+// in place of an explicit transposed() copy. C must already have the shape
+// of the product. Matrices and views of them (blocks, rows, columns) are
+// accepted alike.
+void gemm(double alpha, const ConstMatrixView& a, const ConstMatrixView& b,
+          double beta, const MatrixView& c,
+          Transpose trans_a = Transpose::kNone,
+          Transpose trans_b = Transpose::kNone);
+
+// Y = alpha * X + Y.
+void axpy(double alpha, const Matrix& x, Matrix& y);
+
+// X = alpha * X.
+void scal(double alpha, Matrix& x);
+
+}  // namespace task
@@ -0,0 +1,231 @@
+#include "factorization.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gemm.h"
+
+namespace task {
+
+namespace {
+
+// Width of the panels handled by the unblocked kernels; everything outside a
+// panel is updated through gemm.
+const size_t kBlock = 64;
+
+// Solves L X = X in place for a lower triangular n x n L addressed through
+// strides, X being n x r with row stride ldx.
+template <class T>
+void solveLower(size_t n, size_t r, const T* t, size_t rs, size_t cs,
+                bool unit_diagonal, T* x, size_t ldx) {
+  for (size_t i0 = 0; i0 < n; i0 += kBlock) {
+    size_t i1 = std::min(n, i0 + kBlock);
+    gemm(i1 - i0, r, i0, T(-1), t + i0 * rs, rs, cs, x, ldx, 1, T(1),
+         x + i0 * ldx, ldx);
+    for (size_t i = i0; i < i1; ++i) {
+      T* row = x + i * ldx;
+      for (size_t j = i0; j < i; ++j) {
+        T factor = t[i * rs + j * cs];
+        const T* other = x + j * ldx;
+        for (size_t c = 0; c < r; ++c) {
+          row[c] -= factor * other[c];
+        }
+      }
+      if (!unit_diagonal) {
+        T diagonal = t[i * rs + i * cs];
+        for (size_t c = 0; c < r; ++c) {
+          row[c] /= diagonal;
+        }
+      }
+    }
+  }
+}
+
+// Solves U X = X in place for an upper triangular n x n U.
+template <class T>
+void solveUpper(size_t n, size_t r, const T* t, size_t rs, size_t cs, T* x,
+                size_t ldx) {
+  for (size_t i1 = n; i1 > 0;) {
+    size_t i0 = i1 > kBlock ? i1 - kBlock : 0;
+    gemm(i1 - i0, r, n - i1, T(-1), t + i0 * rs + i1 * cs, rs, cs,
+         x + i1 * ldx, ldx, 1, T(1), x + i0 * ldx, ldx);
+    for (size_t i = i1; i-- > i0;) {
+      T* row = x + i * ldx;
+      for (size_t j = i + 1; j < i1; ++j) {
+        T factor = t[i * rs + j * cs];
+        const T* other = x + j * ldx;
+        for (size_t c = 0; c < r; ++c) {
+          row[c] -= factor * other[c];
+        }
+      }
+      T diagonal = t[i * rs + i * cs];
+      for (size_t c = 0; c < r; ++c) {
+        row[c] /= diagonal;
+      }
+    }
+    i1 = i0;
+  }
+}
+
+Matrix columnMatrix(const std::vector<double>& b) {
+  Matrix result(b.size(), 1);
+  std::copy(b.begin(), b.end(), result[0]);
+  return result;
+}
+
+std::vector<double> columnVector(const Matrix& x) {
+  return std::vector<double>(x[0], x[0] + x.getRowSize());
+}
+
+}  // namespace
+
+template <class T>
+T factorLU(T* data, size_t n, size_t* pivots) {
+  T sign = T(1);
+  for (size_t k0 = 0; k0 < n; k0 += kBlock) {
+    size_t k1 = std::min(n, k0 + kBlock);
+    for (size_t k = k0; k < k1; ++k) {
+      size_t pivot = k;
+      for (size_t i = k + 1; i < n; ++i) {
+        if (std::abs(data[i * n + k]) > std::abs(data[pivot * n + k])) {
+          pivot = i;
+        }
+      }
+      pivots[k] = pivot;
+      if (pivot != k) {
+        std::swap_ranges(data + k * n, data + (k + 1) * n, data + pivot * n);
+        sign = -sign;
+      }
+      const T* pivot_row = data + k * n;
+      if (pivot_row[k] == T()) continue;
+      for (size_t i = k + 1; i < n; ++i) {
+        T* row = data + i * n;
+        row[k] /= pivot_row[k];
+        for (size_t j = k + 1; j < k1; ++j) {
+          row[j] -= row[k] * pivot_row[j];
+        }
+      }
+    }
+    if (k1 == n) break;
+    solveLower(k1 - k0, n - k1, data + k0 * n + k0, n, 1, true,
+               data + k0 * n + k1, n);
+    gemm(n - k1, n - k1, k1 - k0, T(-1), data + k1 * n + k0, n, 1,
+         data + k0 * n + k1, n, 1, T(1), data + k1 * n + k1, n);
+  }
+  return sign;
+}
+
+template float factorLU(float*, size_t, size_t*);
+template double factorLU(double*, size_t, size_t*);
+template std::complex<double> factorLU(std::complex<double>*, size_t,
+                                       size_t*);
+
+LU::LU(const Matrix& a) : lu_(a), pivots_(a.getRowSize()) {
+  if (a.getRowSize() != a.getColSize()) {
+    throw SizeMismatchException();
+  }
+  sign_ = factorLU(lu_[0], getSize(), pivots_.data());
+}
+
+size_t LU::getSize() const { return lu_.getRowSize(); }
+
+double LU::det() const {
+  double result = sign_;
+  for (size_t i = 0; i < getSize(); ++i) {
+    result *= lu_[i][i];
+  }
+  return result;
+}
+
+bool LU::isSingular() const {
+  for (size_t i = 0; i < getSize(); ++i) {
+    if (lu_[i][i] == 0.0) return true;
+  }
+  return false;
+}
+
+Matrix LU::solve(const Matrix& b) const {
+  size_t n = getSize();
+  if (b.getRowSize() != n) {
+    throw SizeMismatchException();
+  }
+  if (isSingular()) {
+    throw SingularMatrixException();
+  }
+  Matrix x = b;
+  size_t r = x.getColSize();
+  for (size_t i = 0; i < n; ++i) {
+    if (pivots_[i] != i) {
+      std::swap_ranges(x[i], x[i] + r, x[pivots_[i]]);
+    }
+  }
+  solveLower(n, r, lu_[0], n, 1, true, x[0], r);
+  solveUpper(n, r, lu_[0], n, 1, x[0], r);
+  return x;
+}
+
+std::vector<double> LU::solve(const std::vector<double>& b) const {
+  return columnVector(solve(columnMatrix(b)));
+}
+
+Matrix LU::inverse() const { return solve(Matrix(getSize(), getSize())); }
+
+Cholesky::Cholesky(const Matrix& a) : l_(a.getRowSize(), a.getColSize()) {
+  if (a.getRowSize() != a.getColSize()) {
+    throw SizeMismatchException();
+  }
+  size_t n = getSize();
+  for (size_t i = 0; i < n; ++i) {
+    double* row = l_[i];
+    for (size_t j = 0; j <= i; ++j) {
+      const double* other = l_[j];
+      double sum = a[i][j];
+      for (size_t p = 0; p < j; ++p) {
+        sum -= row[p] * other[p];
+      }
+      if (i == j) {
+        if (sum <= 0.0) {
+          throw NotPositiveDefiniteException();
+        }
+        row[i] = std::sqrt(sum);
+      } else {
+        row[j] = sum / other[j];
+      }
+    }
+    std::fill(row + i + 1, row + n, 0.0);
+  }
+}
+
+size_t Cholesky::getSize() const { return l_.getRowSize(); }
+
+const Matrix& Cholesky::getL() const { return l_; }
+
+double Cholesky::det() const {
+  double result = 1.0;
+  for (size_t i = 0; i < getSize(); ++i) {
+    result *= l_[i][i] * l_[i][i];
+  }
+  return result;
+}
+
+Matrix Cholesky::solve(const Matrix& b) const {
+  size_t n = getSize();
+  if (b.getRowSize() != n) {
+    throw SizeMismatchException();
+  }
+  Matrix x = b;
+  size_t r = x.getColSize();
+  solveLower(n, r, l_[0], n, 1, false, x[0], r);
+  solveUpper(n, r, l_[0], 1, n, x[0], r);
+  return x;
+}
+
+std::vector<double> Cholesky::solve(const std::vector<double>& b) const {
+  return columnVector(solve(columnMatrix(b)));
+}
+
+Matrix Cholesky::inverse() const {
+  return solve(Matrix(getSize(), getSize()));
+}
+
+}  // namespace task
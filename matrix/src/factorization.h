@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "matrix.h"
+
+namespace task {
+
+class SingularMatrixException : public std::exception {};
+class NotPositiveDefiniteException : public std::exception {};
+
+// Blocked PA = LU with partial pivoting of the n x n row-major matrix at
+// data, in place: L (unit diagonal) below the diagonal, U on and above it.
+// Step k swaps row k with row pivots[k]. Returns det(P). Instantiated for
+// float, double and std::complex<double>.
+template <class T>
+T factorLU(T* data, size_t n, size_t* pivots);
+
+// PA = LU with partial pivoting. L (unit diagonal) and U share one matrix.
+class LU {
+ public:
+  explicit LU(const Matrix& a);
+
+  double det() const;
+  bool isSingular() const;
+  size_t getSize() const;
+
+  // Solves A X = B for every column of B at once.
+  Matrix solve(const Matrix& b) const;
+  std::vector<double> solve(const std::vector<double>& b) const;
+  Matrix inverse() const;
+
+ private:
+  Matrix lu_;
+  std::vector<size_t> pivots_;
+  double sign_;
+};
+
+// A = L L^T for a symmetric positive definite A; only the lower triangle of A
+// is read.
+class Cholesky {
+ public:
+  explicit Cholesky(const Matrix& a);
+
+  double det() const;
+  size_t getSize() const;
+  const Matrix& getL() const;
+
+  Matrix solve(const Matrix& b) const;
+  std::vector<double> solve(const std::vector<double>& b) const;
+  Matrix inverse() const;
+
+ private:
+  Matrix l_;
+};
+
+}  // namespace task
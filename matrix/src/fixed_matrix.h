@@ -0,0 +1,369 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+#include "factorization.h"
+#include "matrix.h"
+
+namespace task {
+
+// Stack-allocated Rows x Cols matrix of a real type. Every operation is
+// constexpr, loops have compile-time trip counts so the compiler unrolls
+// them, and operands of mismatched shape do not compile. Like Matrix, a
+// default-constructed FixedMatrix is the identity.
+template <size_t Rows, size_t Cols, class T = double>
+class FixedMatrix {
+  static_assert(std::is_arithmetic_v<T>, "elements must be real numbers");
+  static_assert(Rows > 0 && Cols > 0, "dimensions must be positive");
+
+ public:
+  using Scalar = T;
+
+  constexpr FixedMatrix() : data_() {
+    for (size_t i = 0; i < Rows && i < Cols; ++i) {
+      data_[i][i] = T(1);
+    }
+  }
+  // Row-major values, e.g. FixedMatrix<2, 2>({1, 2, 3, 4}).
+  constexpr explicit FixedMatrix(const T (&values)[Rows * Cols]) : data_() {
+    for (size_t i = 0; i < Rows; ++i) {
+      for (size_t j = 0; j < Cols; ++j) {
+        data_[i][j] = values[i * Cols + j];
+      }
+    }
+  }
+
+  static constexpr FixedMatrix zero() {
+    FixedMatrix result;
+    result.fill(T());
+    return result;
+  }
+  static FixedMatrix fromMatrix(const BasicMatrix<T>& matrix) {
+    if (matrix.getRowSize() != Rows || matrix.getColSize() != Cols) {
+      throw SizeMismatchException();
+    }
+    FixedMatrix result;
+    for (size_t i = 0; i < Rows; ++i) {
+      for (size_t j = 0; j < Cols; ++j) {
+        result.data_[i][j] = matrix[i][j];
+      }
+    }
+    return result;
+  }
+  BasicMatrix<T> toMatrix() const {
+    BasicMatrix<T> result(Rows, Cols);
+    for (size_t i = 0; i < Rows; ++i) {
+      for (size_t j = 0; j < Cols; ++j) {
+        result[i][j] = data_[i][j];
+      }
+    }
+    return result;
+  }
+
+  static constexpr size_t getRowSize() { return Rows; }
+  static constexpr size_t getColSize() { return Cols; }
+
+  constexpr T* operator[](size_t row) { return data_[row]; }
+  constexpr const T* operator[](size_t row) const { return data_[row]; }
+  constexpr T coeff(size_t row, size_t col) const { return data_[row][col]; }
+  constexpr T& get(size_t row, size_t col) {
+    checkBounds(row, col);
+    return data_[row][col];
+  }
+  constexpr const T& get(size_t row, size_t col) const {
+    checkBounds(row, col);
+    return data_[row][col];
+  }
+  constexpr void set(size_t row, size_t col, const T& value) {
+    get(row, col) = value;
+  }
+  constexpr void fill(const T& value) {
+    for (size_t i = 0; i < Rows; ++i) {
+      for (size_t j = 0; j < Cols; ++j) {
+        data_[i][j] = value;
+      }
+    }
+  }
+
+  constexpr FixedMatrix& operator+=(const FixedMatrix& a) {
+    for (size_t i = 0; i < Rows; ++i) {
+      for (size_t j = 0; j < Cols; ++j) {
+        data_[i][j] += a.data_[i][j];
+      }
+    }
+    return *this;
+  }
+  constexpr FixedMatrix& operator-=(const FixedMatrix& a) {
+    for (size_t i = 0; i < Rows; ++i) {
+      for (size_t j = 0; j < Cols; ++j) {
+        data_[i][j] -= a.data_[i][j];
+      }
+    }
+    return *this;
+  }
+  constexpr FixedMatrix& operator*=(const T& number) {
+    for (size_t i = 0; i < Rows; ++i) {
+      for (size_t j = 0; j < Cols; ++j) {
+        data_[i][j] *= number;
+      }
+    }
+    return *this;
+  }
+  constexpr FixedMatrix& operator*=(const FixedMatrix<Cols, Cols, T>& a) {
+    return *this = *this * a;
+  }
+
+  constexpr FixedMatrix<Cols, Rows, T> transposed() const {
+    FixedMatrix<Cols, Rows, T> result;
+    for (size_t i = 0; i < Rows; ++i) {
+      for (size_t j = 0; j < Cols; ++j) {
+        result[j][i] = data_[i][j];
+      }
+    }
+    return result;
+  }
+
+  constexpr T trace() const {
+    static_assert(Rows == Cols, "trace of a non-square matrix");
+    T result = T();
+    for (size_t i = 0; i < Rows; ++i) {
+      result += data_[i][i];
+    }
+    return result;
+  }
+
+  // Closed form up to 4 x 4; larger matrices are eliminated, exactly
+  // (Bareiss) for integers.
+  constexpr T det() const {
+    static_assert(Rows == Cols, "determinant of a non-square matrix");
+    const auto& a = data_;
+    if constexpr (Rows == 1) {
+      return a[0][0];
+    } else if constexpr (Rows == 2) {
+      return a[0][0] * a[1][1] - a[0][1] * a[1][0];
+    } else if constexpr (Rows == 3) {
+      return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+             a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+             a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    } else if constexpr (Rows == 4) {
+      // Laplace expansion along the 2 x 2 minors of the top two rows.
+      T s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+      T s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+      T s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+      T s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+      T s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+      T s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+      T c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+      T c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+      T c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+      T c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+      T c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+      T c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+      return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    } else {
+      return eliminationDet();
+    }
+  }
+
+  // Adjugate over the determinant up to 4 x 4, Gauss-Jordan beyond. Throws
+  // SingularMatrixException for a zero determinant or pivot.
+  constexpr FixedMatrix inverse() const {
+    static_assert(Rows == Cols, "inverse of a non-square matrix");
+    static_assert(std::is_floating_point_v<T>, "inverse needs a field");
+    if constexpr (Rows <= 4) {
+      T determinant = det();
+      if (determinant == T()) {
+        throw SingularMatrixException();
+      }
+      return adjugate() * (T(1) / determinant);
+    } else {
+      return gaussJordanInverse();
+    }
+  }
+
+  // Transposed matrix of cofactors: adjugate() * A = det() * I.
+  constexpr FixedMatrix adjugate() const {
+    static_assert(Rows == Cols, "adjugate of a non-square matrix");
+    FixedMatrix result;
+    if constexpr (Rows > 1) {
+      for (size_t i = 0; i < Rows; ++i) {
+        for (size_t j = 0; j < Cols; ++j) {
+          T cofactor = minor(i, j).det();
+          result[j][i] = (i + j) % 2 == 0 ? cofactor : -cofactor;
+        }
+      }
+    }
+    return result;
+  }
+
+  // The matrix without one row and one column.
+  constexpr FixedMatrix<Rows - 1, Cols - 1, T> minor(size_t row,
+                                                     size_t col) const {
+    FixedMatrix<Rows - 1, Cols - 1, T> result;
+    for (size_t i = 0; i + 1 < Rows; ++i) {
+      for (size_t j = 0; j + 1 < Cols; ++j) {
+        result[i][j] = data_[i < row ? i : i + 1][j < col ? j : j + 1];
+      }
+    }
+    return result;
+  }
+
+ private:
+  constexpr void checkBounds(size_t row, size_t col) const {
+    if (row >= Rows || col >= Cols) {
+      throw OutOfBoundsException();
+    }
+  }
+
+  static constexpr T magnitude(T value) { return value < T() ? -value : value; }
+
+  constexpr void swapRows(size_t a, size_t b) {
+    for (size_t j = 0; j < Cols; ++j) {
+      T value = data_[a][j];
+      data_[a][j] = data_[b][j];
+      data_[b][j] = value;
+    }
+  }
+
+  constexpr T eliminationDet() const {
+    FixedMatrix a = *this;
+    T result = T(1);
+    T previous = T(1);
+    for (size_t k = 0; k < Rows; ++k) {
+      size_t pivot = k;
+      for (size_t i = k + 1; i < Rows; ++i) {
+        if (magnitude(a[i][k]) > magnitude(a[pivot][k])) pivot = i;
+      }
+      if (a[pivot][k] == T()) return T();
+      if (pivot != k) {
+        a.swapRows(k, pivot);
+        result = -result;
+      }
+      for (size_t i = k + 1; i < Rows; ++i) {
+        for (size_t j = k + 1; j < Cols; ++j) {
+          if constexpr (std::is_integral_v<T>) {
+            a[i][j] = (a[i][j] * a[k][k] - a[i][k] * a[k][j]) / previous;
+          } else {
+            a[i][j] -= a[i][k] / a[k][k] * a[k][j];
+          }
+        }
+      }
+      if constexpr (std::is_integral_v<T>) {
+        previous = a[k][k];
+      } else {
+        result *= a[k][k];
+      }
+    }
+    if constexpr (std::is_integral_v<T>) {
+      return result * a[Rows - 1][Rows - 1];
+    } else {
+      return result;
+    }
+  }
+
+  constexpr FixedMatrix gaussJordanInverse() const {
+    FixedMatrix a = *this;
+    FixedMatrix result;
+    for (size_t k = 0; k < Rows; ++k) {
+      size_t pivot = k;
+      for (size_t i = k + 1; i < Rows; ++i) {
+        if (magnitude(a[i][k]) > magnitude(a[pivot][k])) pivot = i;
+      }
+      if (a[pivot][k] == T()) {
+        throw SingularMatrixException();
+      }
+      a.swapRows(k, pivot);
+      result.swapRows(k, pivot);
+      T scale = T(1) / a[k][k];
+      for (size_t j = 0; j < Cols; ++j) {
+        a[k][j] *= scale;
+        result[k][j] *= scale;
+      }
+      for (size_t i = 0; i < Rows; ++i) {
+        if (i == k) continue;
+        T factor = a[i][k];
+        for (size_t j = 0; j < Cols; ++j) {
+          a[i][j] -= factor * a[k][j];
+          result[i][j] -= factor * result[k][j];
+        }
+      }
+    }
+    return result;
+  }
+
+  T data_[Rows][Cols];
+};
+
+template <size_t Rows, size_t Cols, class T>
+constexpr FixedMatrix<Rows, Cols, T> operator+(
+    FixedMatrix<Rows, Cols, T> a, const FixedMatrix<Rows, Cols, T>& b) {
+  return a += b;
+}
+
+template <size_t Rows, size_t Cols, class T>
+constexpr FixedMatrix<Rows, Cols, T> operator-(
+    FixedMatrix<Rows, Cols, T> a, const FixedMatrix<Rows, Cols, T>& b) {
+  return a -= b;
+}
+
+template <size_t Rows, size_t Cols, class T>
+constexpr FixedMatrix<Rows, Cols, T> operator-(FixedMatrix<Rows, Cols, T> a) {
+  return a *= T(-1);
+}
+
+template <size_t Rows, size_t Cols, class T>
+constexpr FixedMatrix<Rows, Cols, T> operator*(FixedMatrix<Rows, Cols, T> a,
+                                               const T& number) {
+  return a *= number;
+}
+
+template <size_t Rows, size_t Cols, class T>
+constexpr FixedMatrix<Rows, Cols, T> operator*(
+    const T& number, FixedMatrix<Rows, Cols, T> a) {
+  return a *= number;
+}
+
+template <size_t Rows, size_t Inner, size_t Cols, class T>
+constexpr FixedMatrix<Rows, Cols, T> operator*(
+    const FixedMatrix<Rows, Inner, T>& a,
+    const FixedMatrix<Inner, Cols, T>& b) {
+  FixedMatrix<Rows, Cols, T> result = FixedMatrix<Rows, Cols, T>::zero();
+  for (size_t i = 0; i < Rows; ++i) {
+    for (size_t k = 0; k < Inner; ++k) {
+      for (size_t j = 0; j < Cols; ++j) {
+        result[i][j] += a[i][k] * b[k][j];
+      }
+    }
+  }
+  return result;
+}
+
+// Equal within tolerance<T>(), like Matrix.
+template <size_t Rows, size_t Cols, class T>
+constexpr bool operator==(const FixedMatrix<Rows, Cols, T>& a,
+                          const FixedMatrix<Rows, Cols, T>& b) {
+  for (size_t i = 0; i < Rows; ++i) {
+    for (size_t j = 0; j < Cols; ++j) {
+      T difference = a[i][j] - b[i][j];
+      if (difference > tolerance<T>() || -difference > tolerance<T>()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <size_t Rows, size_t Cols, class T>
+constexpr bool operator!=(const FixedMatrix<Rows, Cols, T>& a,
+                          const FixedMatrix<Rows, Cols, T>& b) {
+  return !(a == b);
+}
+
+template <size_t Rows, size_t Cols, class T>
+std::ostream& operator<<(std::ostream& output,
+                         const FixedMatrix<Rows, Cols, T>& matrix) {
+  return output << matrix.toMatrix();
+}
+
+}  // namespace task
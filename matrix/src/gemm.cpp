@@ -0,0 +1,217 @@
+#include "gemm.h"
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace task {
+
+namespace {
+
+// Register tile of the micro-kernel and cache blocking of the packed panels:
+// a KC x NR sliver of B stays in L1, an MC x KC block of A in L2 and a
+// KC x NC panel of B in L3. Complex elements get a narrower tile to keep the
+// accumulators in registers.
+const size_t kMr = 4;
+template <class T>
+constexpr size_t kNr = sizeof(T) > sizeof(double) ? 4 : 8;
+const size_t kMc = 128;
+const size_t kKc = 256;
+const size_t kNc = 2048;
+
+// Products with fewer multiply-adds than this run on the calling thread only.
+const size_t kParallelThreshold = 1 << 21;
+
+template <class T>
+struct AlignedDeleter {
+  void operator()(T* buffer) const {
+    ::operator delete(buffer, std::align_val_t(64));
+  }
+};
+
+size_t roundUp(size_t value, size_t step) {
+  return (value + step - 1) / step * step;
+}
+
+template <class T>
+class PackBuffer {
+ public:
+  T* reserve(size_t size) {
+    if (size > capacity_) {
+      buffer_.reset(static_cast<T*>(
+          ::operator new(size * sizeof(T), std::align_val_t(64))));
+      capacity_ = size;
+    }
+    return buffer_.get();
+  }
+
+ private:
+  std::unique_ptr<T, AlignedDeleter<T>> buffer_;
+  size_t capacity_ = 0;
+};
+
+// Copies an mc x kc block of A into row panels of kMr rows, each stored
+// column by column and zero padded to a full panel.
+template <class T>
+void packA(size_t mc, size_t kc, const T* a, size_t rs, size_t cs, T* packed) {
+  for (size_t i = 0; i < mc; i += kMr) {
+    size_t rows = std::min(kMr, mc - i);
+    for (size_t p = 0; p < kc; ++p) {
+      for (size_t r = 0; r < rows; ++r) {
+        packed[r] = a[(i + r) * rs + p * cs];
+      }
+      for (size_t r = rows; r < kMr; ++r) {
+        packed[r] = T();
+      }
+      packed += kMr;
+    }
+  }
+}
+
+// Copies a kc x nc panel of B into column panels of kNr columns, each stored
+// row by row and zero padded to a full panel.
+template <class T>
+void packB(size_t kc, size_t nc, const T* b, size_t rs, size_t cs, T* packed) {
+  for (size_t j = 0; j < nc; j += kNr<T>) {
+    size_t cols = std::min(kNr<T>, nc - j);
+    for (size_t p = 0; p < kc; ++p) {
+      const T* src = b + p * rs + j * cs;
+      for (size_t c = 0; c < cols; ++c) {
+        packed[c] = src[c * cs];
+      }
+      for (size_t c = cols; c < kNr<T>; ++c) {
+        packed[c] = T();
+      }
+      packed += kNr<T>;
+    }
+  }
+}
+
+// C[0..rows, 0..cols] += alpha * Apanel * Bpanel.
+template <class T>
+void microKernel(size_t kc, T alpha, const T* a, const T* b, T* c,
+                 size_t c_row_stride, size_t rows, size_t cols) {
+  T acc[kMr][kNr<T>] = {};
+  for (size_t p = 0; p < kc; ++p) {
+    for (size_t i = 0; i < kMr; ++i) {
+      for (size_t j = 0; j < kNr<T>; ++j) {
+        acc[i][j] += a[i] * b[j];
+      }
+    }
+    a += kMr;
+    b += kNr<T>;
+  }
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      c[i * c_row_stride + j] += alpha * acc[i][j];
+    }
+  }
+}
+
+template <class T>
+void scaleC(size_t m, size_t n, T beta, T* c, size_t c_row_stride) {
+  if (beta == T(1)) return;
+  for (size_t i = 0; i < m; ++i) {
+    T* row = c + i * c_row_stride;
+    if (beta == T()) {
+      std::fill_n(row, n, T());
+    } else {
+      for (size_t j = 0; j < n; ++j) {
+        row[j] *= beta;
+      }
+    }
+  }
+}
+
+template <class T>
+void gemmSerial(size_t m, size_t n, size_t k, T alpha, const T* a,
+                size_t a_row_stride, size_t a_col_stride, const T* b,
+                size_t b_row_stride, size_t b_col_stride, T* c,
+                size_t c_row_stride) {
+  thread_local PackBuffer<T> a_buffer;
+  thread_local PackBuffer<T> b_buffer;
+  size_t max_kc = std::min(kKc, k);
+  T* packed_a = a_buffer.reserve(roundUp(std::min(kMc, m), kMr) * max_kc);
+  T* packed_b = b_buffer.reserve(roundUp(std::min(kNc, n), kNr<T>) * max_kc);
+
+  for (size_t jc = 0; jc < n; jc += kNc) {
+    size_t nc = std::min(kNc, n - jc);
+    for (size_t pc = 0; pc < k; pc += kKc) {
+      size_t kc = std::min(kKc, k - pc);
+      packB(kc, nc, b + pc * b_row_stride + jc * b_col_stride, b_row_stride,
+            b_col_stride, packed_b);
+      for (size_t ic = 0; ic < m; ic += kMc) {
+        size_t mc = std::min(kMc, m - ic);
+        packA(mc, kc, a + ic * a_row_stride + pc * a_col_stride, a_row_stride,
+              a_col_stride, packed_a);
+        for (size_t jr = 0; jr < nc; jr += kNr<T>) {
+          for (size_t ir = 0; ir < mc; ir += kMr) {
+            microKernel(kc, alpha, packed_a + ir * kc, packed_b + jr * kc,
+                        c + (ic + ir) * c_row_stride + jc + jr, c_row_stride,
+                        std::min(kMr, mc - ir), std::min(kNr<T>, nc - jr));
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+template <class T>
+void gemm(size_t m, size_t n, size_t k, T alpha, const T* a,
+          size_t a_row_stride, size_t a_col_stride, const T* b,
+          size_t b_row_stride, size_t b_col_stride, T beta, T* c,
+          size_t c_row_stride) {
+  scaleC(m, n, beta, c, c_row_stride);
+  if (m == 0 || n == 0 || k == 0 || alpha == T()) return;
+
+  ThreadPool& pool = ThreadPool::instance();
+  size_t threads = pool.getThreadCount();
+  if (threads == 1 || m * n * k < kParallelThreshold) {
+    gemmSerial(m, n, k, alpha, a, a_row_stride, a_col_stride, b, b_row_stride,
+               b_col_stride, c, c_row_stride);
+    return;
+  }
+
+  // Each task owns a panel of whole register tiles of C, cut along the longer
+  // side so that there are enough panels to go round. Every task packs the
+  // whole of the other operand for itself.
+  bool split_rows = m >= n;
+  size_t extent = split_rows ? m : n;
+  size_t step = split_rows ? kMr : kNr<T>;
+  size_t panel = roundUp((extent + threads - 1) / threads, step);
+  size_t panels = (extent + panel - 1) / panel;
+  pool.parallelFor(panels, [&](size_t index) {
+    size_t begin = index * panel;
+    size_t size = std::min(panel, extent - begin);
+    if (split_rows) {
+      gemmSerial(size, n, k, alpha, a + begin * a_row_stride, a_row_stride,
+                 a_col_stride, b, b_row_stride, b_col_stride,
+                 c + begin * c_row_stride, c_row_stride);
+    } else {
+      gemmSerial(m, size, k, alpha, a, a_row_stride, a_col_stride,
+                 b + begin * b_col_stride, b_row_stride, b_col_stride,
+                 c + begin, c_row_stride);
+    }
+  });
+}
+
+template void gemm(size_t, size_t, size_t, float, const float*, size_t, size_t,
+                   const float*, size_t, size_t, float, float*, size_t);
+template void gemm(size_t, size_t, size_t, double, const double*, size_t,
+                   size_t, const double*, size_t, size_t, double, double*,
+                   size_t);
+template void gemm(size_t, size_t, size_t, int64_t, const int64_t*, size_t,
+                   size_t, const int64_t*, size_t, size_t, int64_t, int64_t*,
+                   size_t);
+template void gemm(size_t, size_t, size_t, std::complex<double>,
+                   const std::complex<double>*, size_t, size_t,
+                   const std::complex<double>*, size_t, size_t,
+                   std::complex<double>, std::complex<double>*, size_t);
+
+}  // namespace task
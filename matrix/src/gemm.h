@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+namespace task {
+
+// C = alpha * A * B + beta * C for an m x k matrix A, a k x n matrix B and an
+// m x n matrix C. Every operand is addressed through a row and a column
+// stride, so transposed operands are passed by swapping the strides.
+// Instantiated for float, double, int64_t and std::complex<double>.
+template <class T>
+void gemm(size_t m, size_t n, size_t k, T alpha, const T* a,
+          size_t a_row_stride, size_t a_col_stride, const T* b,
+          size_t b_row_stride, size_t b_col_stride, T beta, T* c,
+          size_t c_row_stride);
+
+}  // namespace task
@@ -0,0 +1,152 @@
+#include "instrumentation.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace task {
+
+namespace {
+
+struct AtomicStats {
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> nanoseconds{0};
+  std::atomic<uint64_t> flops{0};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes_allocated{0};
+  std::atomic<uint64_t> temporaries{0};
+};
+
+// Updated with relaxed atomics: the counters are independent totals and may
+// be read while other threads are still adding to them.
+AtomicStats stats[kOperationCount];
+
+#ifdef MATRIX_INSTRUMENTATION
+
+thread_local Operation current_operation = Operation::kOther;
+
+AtomicStats& statsOf(Operation operation) {
+  return stats[static_cast<size_t>(operation)];
+}
+
+uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+#endif
+
+}  // namespace
+
+const char* getOperationName(Operation operation) {
+  switch (operation) {
+    case Operation::kConstruct:
+      return "construct";
+    case Operation::kCopy:
+      return "copy";
+    case Operation::kEvaluate:
+      return "evaluate";
+    case Operation::kMultiply:
+      return "multiply";
+    case Operation::kDet:
+      return "det";
+    case Operation::kTranspose:
+      return "transpose";
+    case Operation::kResize:
+      return "resize";
+    case Operation::kPow:
+      return "pow";
+    case Operation::kRead:
+      return "read";
+    case Operation::kWrite:
+      return "write";
+    default:
+      return "other";
+  }
+}
+
+std::array<OperationStats, kOperationCount> getOperationStats() {
+  std::array<OperationStats, kOperationCount> result;
+  for (size_t i = 0; i < kOperationCount; ++i) {
+    result[i].calls = stats[i].calls.load(std::memory_order_relaxed);
+    result[i].nanoseconds =
+        stats[i].nanoseconds.load(std::memory_order_relaxed);
+    result[i].flops = stats[i].flops.load(std::memory_order_relaxed);
+    result[i].allocations =
+        stats[i].allocations.load(std::memory_order_relaxed);
+    result[i].bytes_allocated =
+        stats[i].bytes_allocated.load(std::memory_order_relaxed);
+    result[i].temporaries =
+        stats[i].temporaries.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+void resetOperationStats() {
+  for (AtomicStats& entry : stats) {
+    entry.calls.store(0, std::memory_order_relaxed);
+    entry.nanoseconds.store(0, std::memory_order_relaxed);
+    entry.flops.store(0, std::memory_order_relaxed);
+    entry.allocations.store(0, std::memory_order_relaxed);
+    entry.bytes_allocated.store(0, std::memory_order_relaxed);
+    entry.temporaries.store(0, std::memory_order_relaxed);
+  }
+}
+
+void dumpOperationStats(std::ostream& output) {
+  std::array<OperationStats, kOperationCount> snapshot = getOperationStats();
+  for (size_t i = 0; i < kOperationCount; ++i) {
+    const OperationStats& entry = snapshot[i];
+    if (entry.calls == 0 && entry.allocations == 0) continue;
+    output << getOperationName(static_cast<Operation>(i))
+           << " calls=" << entry.calls
+           << " seconds=" << entry.nanoseconds * 1e-9
+           << " flops=" << entry.flops
+           << " allocations=" << entry.allocations
+           << " bytes=" << entry.bytes_allocated
+           << " temporaries=" << entry.temporaries << "\n";
+  }
+}
+
+#ifdef MATRIX_INSTRUMENTATION
+
+OperationScope::OperationScope(Operation operation, double flops)
+    : operation_(operation),
+      outermost_(current_operation == Operation::kOther),
+      start_(0) {
+  if (!outermost_) return;
+  current_operation = operation;
+  statsOf(operation).calls.fetch_add(1, std::memory_order_relaxed);
+  addFlops(flops);
+  start_ = now();
+}
+
+OperationScope::~OperationScope() {
+  if (!outermost_) return;
+  statsOf(operation_).nanoseconds.fetch_add(now() - start_,
+                                            std::memory_order_relaxed);
+  current_operation = Operation::kOther;
+}
+
+void OperationScope::addFlops(double flops) {
+  if (outermost_ && flops > 0) {
+    statsOf(operation_).flops.fetch_add(static_cast<uint64_t>(flops),
+                                        std::memory_order_relaxed);
+  }
+}
+
+void recordAllocation(size_t bytes) {
+  AtomicStats& entry = statsOf(current_operation);
+  entry.allocations.fetch_add(1, std::memory_order_relaxed);
+  entry.bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void recordTemporary() {
+  if (current_operation == Operation::kOther) return;
+  statsOf(current_operation)
+      .temporaries.fetch_add(1, std::memory_order_relaxed);
+}
+
+#endif
+
+}  // namespace task
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+namespace task {
+
+// Matrix operations counted when the library is built with
+// -DMATRIX_INSTRUMENTATION. Every translation unit must agree on the macro.
+// Without it the hooks below are empty inline functions and the counters
+// stay at zero.
+enum class Operation {
+  kConstruct,
+  kCopy,
+  kEvaluate,
+  kMultiply,
+  kDet,
+  kTranspose,
+  kResize,
+  kPow,
+  kRead,
+  kWrite,
+  // Allocations made outside every other operation.
+  kOther,
+  kCount
+};
+
+const size_t kOperationCount = static_cast<size_t>(Operation::kCount);
+
+// Totals since the last reset. Only the outermost operation on a thread is
+// counted: the work of the operations it runs internally is part of its
+// own, so allocations show which call created a temporary. Temporaries are
+// the matrices constructed while an operation runs, including the result
+// it returns; matrices the caller constructs directly are not counted.
+struct OperationStats {
+  uint64_t calls = 0;
+  uint64_t nanoseconds = 0;
+  uint64_t flops = 0;
+  uint64_t allocations = 0;
+  uint64_t bytes_allocated = 0;
+  uint64_t temporaries = 0;
+};
+
+const char* getOperationName(Operation operation);
+std::array<OperationStats, kOperationCount> getOperationStats();
+void resetOperationStats();
+// One line per operation that was called or allocated, e.g.
+// "multiply calls=2 seconds=0.01 flops=4000000 allocations=2 bytes=64000
+// temporaries=2".
+void dumpOperationStats(std::ostream& output);
+
+#ifdef MATRIX_INSTRUMENTATION
+
+// Counts one call of operation and its time until destruction, unless
+// another scope is already active on this thread.
+class OperationScope {
+ public:
+  explicit OperationScope(Operation operation, double flops = 0);
+  OperationScope(const OperationScope&) = delete;
+  OperationScope& operator=(const OperationScope&) = delete;
+  ~OperationScope();
+
+  void addFlops(double flops);
+
+ private:
+  Operation operation_;
+  bool outermost_;
+  uint64_t start_;
+};
+
+// Called for every matrix buffer that is allocated.
+void recordAllocation(size_t bytes);
+// Called for every matrix constructed with its own elements, before the
+// constructor opens its own scope.
+void recordTemporary();
+
+#else
+
+class OperationScope {
+ public:
+  explicit OperationScope(Operation, double = 0) {}
+  OperationScope(const OperationScope&) = delete;
+  OperationScope& operator=(const OperationScope&) = delete;
+
+  void addFlops(double) {}
+};
+
+inline void recordAllocation(size_t) {}
+inline void recordTemporary() {}
+
+#endif
+
+}  // namespace task
@@ -1,349 +1,622 @@
 #include "matrix.h"
 
-using namespace task;
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "factorization.h"
+#include "gemm.h"
+
+namespace task {
+
+namespace {
+
+#ifdef MATRIX_COPY_ON_WRITE
+// Shared buffers keep their reference count in an alignment-sized block in
+// front of the elements.
+const size_t kBufferHeader = kMatrixAlignment;
+
+std::atomic<size_t>& referenceCount(void* buffer) {
+  return *reinterpret_cast<std::atomic<size_t>*>(static_cast<char*>(buffer) -
+                                                 kBufferHeader);
+}
+#else
+const size_t kBufferHeader = 0;
+#endif
+
+// Set by the innermost MatrixResourceScope of the thread, if any.
+thread_local std::pmr::memory_resource* scoped_resource = nullptr;
+
+// Tiles small enough for a source and a destination tile to share L1.
+const size_t kTransposeBlock = 32;
+
+// dst (cols x rows) = src (rows x cols)^T, one tile at a time.
+template <class T>
+void transposeCopy(const T* src, size_t rows, size_t cols, T* dst) {
+  for (size_t i0 = 0; i0 < rows; i0 += kTransposeBlock) {
+    size_t i1 = std::min(rows, i0 + kTransposeBlock);
+    for (size_t j0 = 0; j0 < cols; j0 += kTransposeBlock) {
+      size_t j1 = std::min(cols, j0 + kTransposeBlock);
+      for (size_t i = i0; i < i1; ++i) {
+        for (size_t j = j0; j < j1; ++j) {
+          dst[j * rows + i] = src[i * cols + j];
+        }
+      }
+    }
+  }
+}
+
+// Swaps the block rows [r0, r1) x cols [c0, c1) of a square n x n matrix with
+// its mirror image, halving the longer side until the block is small.
+template <class T>
+void swapMirrorBlocks(T* data, size_t n, size_t r0, size_t r1, size_t c0,
+                      size_t c1) {
+  if (r1 - r0 <= kTransposeBlock && c1 - c0 <= kTransposeBlock) {
+    for (size_t i = r0; i < r1; ++i) {
+      for (size_t j = c0; j < c1; ++j) {
+        std::swap(data[i * n + j], data[j * n + i]);
+      }
+    }
+  } else if (r1 - r0 >= c1 - c0) {
+    size_t mid = r0 + (r1 - r0) / 2;
+    swapMirrorBlocks(data, n, r0, mid, c0, c1);
+    swapMirrorBlocks(data, n, mid, r1, c0, c1);
+  } else {
+    size_t mid = c0 + (c1 - c0) / 2;
+    swapMirrorBlocks(data, n, r0, r1, c0, mid);
+    swapMirrorBlocks(data, n, r0, r1, mid, c1);
+  }
+}
+
+// Transposes the diagonal block [begin, end) of a square matrix in place.
+template <class T>
+void transposeDiagonal(T* data, size_t n, size_t begin, size_t end) {
+  if (end - begin <= kTransposeBlock) {
+    for (size_t i = begin; i < end; ++i) {
+      for (size_t j = i + 1; j < end; ++j) {
+        std::swap(data[i * n + j], data[j * n + i]);
+      }
+    }
+    return;
+  }
+  size_t mid = begin + (end - begin) / 2;
+  transposeDiagonal(data, n, begin, mid);
+  transposeDiagonal(data, n, mid, end);
+  swapMirrorBlocks(data, n, begin, mid, mid, end);
+}
+
+// Bareiss fraction-free elimination: every division is exact, so integer
+// determinants come out exact while all intermediates stay minors of a.
+template <class T>
+T bareissDet(BasicMatrix<T> a) {
+  size_t n = a.getRowSize();
+  T sign = T(1);
+  T previous = T(1);
+  for (size_t k = 0; k + 1 < n; ++k) {
+    if (a[k][k] == T()) {
+      size_t pivot = k + 1;
+      while (pivot < n && a[pivot][k] == T()) ++pivot;
+      if (pivot == n) return T();
+      std::swap_ranges(a[k], a[k] + n, a[pivot]);
+      sign = -sign;
+    }
+    for (size_t i = k + 1; i < n; ++i) {
+      for (size_t j = k + 1; j < n; ++j) {
+        a[i][j] = (a[i][j] * a[k][k] - a[i][k] * a[k][j]) / previous;
+      }
+    }
+    previous = a[k][k];
+  }
+  return n == 0 ? T(1) : sign * a[n - 1][n - 1];
+}
 
-size_t Matrix::getRowSize() const { return row_size_; }
+}  // namespace
 
-size_t Matrix::getColSize() const { return col_size_; }
+std::pmr::memory_resource* getMatrixResource() {
+  return scoped_resource != nullptr ? scoped_resource
+                                    : std::pmr::get_default_resource();
+}
 
-void Matrix::setRowSize(size_t size) { row_size_ = size; }
+MatrixResourceScope::MatrixResourceScope(std::pmr::memory_resource* resource)
+    : previous_(scoped_resource) {
+  scoped_resource = resource;
+}
 
-void Matrix::setColSize(size_t size) { col_size_ = size; }
+MatrixResourceScope::~MatrixResourceScope() { scoped_resource = previous_; }
+
+template <class T>
+size_t BasicMatrix<T>::getRowSize() const {
+  return row_size_;
+}
+
+template <class T>
+size_t BasicMatrix<T>::getColSize() const {
+  return col_size_;
+}
+
+template <class T>
+std::pmr::memory_resource* BasicMatrix<T>::getResource() const {
+  return resource_;
+}
+
+template <class T>
+void BasicMatrix<T>::setRowSize(size_t size) {
+  row_size_ = size;
+}
+
+template <class T>
+void BasicMatrix<T>::setColSize(size_t size) {
+  col_size_ = size;
+}
+
+template <class T>
+size_t BasicMatrix<T>::elementCount() const {
+  return getRowSize() * getColSize();
+}
+
+template <class T>
+T* BasicMatrix<T>::inlineBuffer() {
+  return reinterpret_cast<T*>(inline_buffer_);
+}
 
-Matrix::Matrix() {
+template <class T>
+bool BasicMatrix<T>::isInline() const {
+  return data_ == reinterpret_cast<const T*>(inline_buffer_);
+}
+
+template <class T>
+T* BasicMatrix<T>::allocateBuffer(size_t size) {
+  if (size * sizeof(T) <= kInlineBytes) {
+    return inlineBuffer();
+  }
+  size_t bytes = std::max(size, size_t(1)) * sizeof(T);
+  recordAllocation(bytes);
+  char* buffer = static_cast<char*>(
+      resource_->allocate(kBufferHeader + bytes, kMatrixAlignment));
+#ifdef MATRIX_COPY_ON_WRITE
+  new (buffer) std::atomic<size_t>(1);
+#endif
+  return reinterpret_cast<T*>(buffer + kBufferHeader);
+}
+
+template <class T>
+void BasicMatrix<T>::freeBuffer(T* buffer, size_t size) const {
+  if (buffer == nullptr ||
+      buffer == reinterpret_cast<const T*>(inline_buffer_)) {
+    return;
+  }
+#ifdef MATRIX_COPY_ON_WRITE
+  if (referenceCount(buffer).fetch_sub(1, std::memory_order_acq_rel) > 1) {
+    return;
+  }
+#endif
+  size_t bytes = std::max(size, size_t(1)) * sizeof(T);
+  resource_->deallocate(reinterpret_cast<char*>(buffer) - kBufferHeader,
+                        kBufferHeader + bytes, kMatrixAlignment);
+}
+
+template <class T>
+BasicMatrix<T>::BasicMatrix() {
+  recordTemporary();
+  OperationScope scope(Operation::kConstruct);
   setRowSize(1);
   setColSize(1);
-  data_ = new double*[getRowSize()];
-  data_[0] = new double[getColSize()];
-  data_[0][0] = 1.0;
+  data_ = allocateBuffer(1);
+  data_[0] = T(1);
 }
 
-Matrix::Matrix(size_t rows, size_t cols) {
+template <class T>
+BasicMatrix<T>::BasicMatrix(size_t rows, size_t cols)
+    : BasicMatrix(rows, cols, getMatrixResource()) {}
+
+template <class T>
+BasicMatrix<T>::BasicMatrix(size_t rows, size_t cols,
+                            std::pmr::memory_resource* resource)
+    : resource_(resource) {
+  recordTemporary();
+  OperationScope scope(Operation::kConstruct);
   setRowSize(rows);
   setColSize(cols);
-  data_ = new double*[rows];
-  for (size_t i = 0; i < rows; ++i) {
-    data_[i] = new double[cols];
-    for (size_t j = 0; j < cols; ++j) {
-      if (i == j) {
-        data_[i][j] = 1;
-      } else {
-        data_[i][j] = 0;
-      }
-    }
+  data_ = allocateBuffer(elementCount());
+  std::fill_n(data_, elementCount(), T());
+  for (size_t i = 0; i < std::min(rows, cols); ++i) {
+    data_[i * cols + i] = T(1);
   }
 }
 
-void Matrix::clearMemory() {
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    delete data_[i];
-  }
-  delete data_;
+template <class T>
+void BasicMatrix<T>::clearMemory() {
+  freeBuffer(data_, elementCount());
 }
 
-Matrix::~Matrix() { clearMemory(); }
+template <class T>
+BasicMatrix<T>::~BasicMatrix() {
+  clearMemory();
+}
 
-void Matrix::copyMatrix(const Matrix& a) {
+template <class T>
+void BasicMatrix<T>::copyMatrix(const BasicMatrix& a) {
+  T* buffer = nullptr;
+#ifdef MATRIX_COPY_ON_WRITE
+  if (a.data_ != nullptr && !a.isInline() && *resource_ == *a.resource_) {
+    referenceCount(a.data_).fetch_add(1, std::memory_order_relaxed);
+    buffer = a.data_;
+  }
+#endif
+  if (buffer == nullptr) {
+    buffer = allocateBuffer(a.elementCount());
+    std::copy_n(a.data_, a.elementCount(), buffer);
+  }
   setRowSize(a.getRowSize());
   setColSize(a.getColSize());
-  data_ = new double*[getRowSize()];
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    data_[i] = new double[getColSize()];
-    for (size_t j = 0; j < getColSize(); ++j) {
-      data_[i][j] = a[i][j];
-    }
+  data_ = buffer;
+}
+
+template <class T>
+void BasicMatrix<T>::detach() {
+#ifdef MATRIX_COPY_ON_WRITE
+  if (data_ == nullptr || isInline() ||
+      referenceCount(data_).load(std::memory_order_acquire) == 1) {
+    return;
   }
+  T* buffer = allocateBuffer(elementCount());
+  std::copy_n(data_, elementCount(), buffer);
+  clearMemory();
+  data_ = buffer;
+#endif
 }
 
-Matrix::Matrix(const Matrix& copy) {
+template <class T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& copy) {
+  recordTemporary();
+  OperationScope scope(Operation::kCopy);
   copyMatrix(copy);
 }
 
-Matrix& Matrix::operator=(const Matrix& a) {
-  if (*this == a) return *this;
-  clearMemory();
+template <class T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& other) noexcept
+    : resource_(other.resource_) {
+  takeBuffer(other);
+}
+
+template <class T>
+void BasicMatrix<T>::takeBuffer(BasicMatrix& other) noexcept {
+  setRowSize(other.getRowSize());
+  setColSize(other.getColSize());
+  if (other.isInline()) {
+    data_ = inlineBuffer();
+    std::copy_n(other.data_, elementCount(), data_);
+  } else {
+    data_ = other.data_;
+  }
+  other.data_ = nullptr;
+  other.setRowSize(0);
+  other.setColSize(0);
+}
+
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& a) {
+  if (this == &a) return *this;
+  OperationScope scope(Operation::kCopy);
+#ifdef MATRIX_COPY_ON_WRITE
+  T* old = data_;
+  size_t old_size = elementCount();
   copyMatrix(a);
+  freeBuffer(old, old_size);
+  return *this;
+#endif
+  if (elementCount() != a.elementCount()) {
+    T* buffer = allocateBuffer(a.elementCount());
+    clearMemory();
+    data_ = buffer;
+  }
+  setRowSize(a.getRowSize());
+  setColSize(a.getColSize());
+  std::copy_n(a.data_, elementCount(), data_);
+  return *this;
+}
+
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& a) {
+  if (this == &a) return *this;
+  if (!a.isInline() && *resource_ != *a.resource_) {
+    return *this = static_cast<const BasicMatrix&>(a);
+  }
+  clearMemory();
+  takeBuffer(a);
   return *this;
 }
 
-void Matrix::checkBounds(size_t row, size_t col) const {
+template <class T>
+void BasicMatrix<T>::checkBounds(size_t row, size_t col) const {
   if (row >= getRowSize() || col >= getColSize()) {
     throw OutOfBoundsException();
   }
 }
 
-double& Matrix::get(size_t row, size_t col) {
+template <class T>
+T& BasicMatrix<T>::get(size_t row, size_t col) {
   checkBounds(row, col);
-  return data_[row][col];
+  return (*this)[row][col];
 }
 
-const double& Matrix::get(size_t row, size_t col) const {
+template <class T>
+const T& BasicMatrix<T>::get(size_t row, size_t col) const {
   checkBounds(row, col);
-  return data_[row][col];
+  return (*this)[row][col];
 }
 
-void Matrix::set(size_t row, size_t col, const double& value) {
+template <class T>
+void BasicMatrix<T>::set(size_t row, size_t col, const T& value) {
   checkBounds(row, col);
-  data_[row][col] = value;
-}
-
-void Matrix::resize(size_t new_rows, size_t new_cols) {
-  Matrix temp = Matrix(new_rows, new_cols);
-  unsigned index;
-  unsigned i_hat;
-  unsigned j_hat;
-  int size = getRowSize() * getColSize();
-  for (size_t i = 0; i < new_rows; ++i) {
-    for (size_t j = 0; j < new_cols; ++j) {
-      index = i * new_cols + j;
-      if (index < size) {
-        i_hat = index / getColSize();
-        j_hat = index % getColSize();
-        temp[i][j] = data_[i_hat][j_hat];
-      } else {
-        temp[i][j] = 0.0;
-      }
+  (*this)[row][col] = value;
+}
+
+template <class T>
+void BasicMatrix<T>::resize(size_t new_rows, size_t new_cols) {
+  OperationScope scope(Operation::kResize);
+  size_t old_size = elementCount();
+  size_t new_size = new_rows * new_cols;
+  if (new_size != old_size) {
+    T* buffer = allocateBuffer(new_size);
+    size_t kept = std::min(old_size, new_size);
+    // Both sizes may fit the inline buffer, which then already holds them.
+    if (buffer != data_) {
+      std::copy_n(data_, kept, buffer);
     }
+    std::fill(buffer + kept, buffer + new_size, T());
+    clearMemory();
+    data_ = buffer;
   }
-  *this = temp;
+  setRowSize(new_rows);
+  setColSize(new_cols);
 }
 
-double* Matrix::operator[](size_t row) { return data_[row]; }
+template <class T>
+T* BasicMatrix<T>::operator[](size_t row) {
+  detach();
+  return data_ + row * getColSize();
+}
 
-double* Matrix::operator[](size_t row) const { return data_[row]; }
+template <class T>
+T* BasicMatrix<T>::operator[](size_t row) const {
+  return data_ + row * getColSize();
+}
 
-void Matrix::checkSize(const Matrix& a) const {
+template <class T>
+void BasicMatrix<T>::checkSize(const BasicMatrix& a) const {
   if (a.getRowSize() != getRowSize() || a.getColSize() != getColSize()) {
     throw SizeMismatchException();
   }
 }
 
-Matrix& Matrix::operator+=(const Matrix& a) {
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const BasicMatrix& a) {
   checkSize(a);
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      data_[i][j] += a[i][j];
-    }
-  }
+  OperationScope scope(Operation::kEvaluate, double(elementCount()));
+  detach();
+  simd::add(elementCount(), data_, a.data_, data_);
   return *this;
 }
 
-Matrix& Matrix::operator-=(const Matrix& a) {
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const BasicMatrix& a) {
   checkSize(a);
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      data_[i][j] -= a[i][j];
-    }
-  }
+  OperationScope scope(Operation::kEvaluate, double(elementCount()));
+  detach();
+  simd::subtract(elementCount(), data_, a.data_, data_);
   return *this;
 }
 
-Matrix& Matrix::operator*=(const Matrix& a) {
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator*=(const BasicMatrix& a) {
   *this = *this * a;
   return *this;
 }
 
-Matrix& Matrix::operator*=(const double& number) {
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      data_[i][j] *= number;
-    }
-  }
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator*=(const T& number) {
+  OperationScope scope(Operation::kEvaluate, double(elementCount()));
+  detach();
+  simd::scale(elementCount(), number, data_, data_);
   return *this;
 }
 
-Matrix Matrix::operator+(const Matrix& a) const {
-  checkSize(a);
-  Matrix b = *this;
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      b[i][j] += a[i][j];
-    }
-  }
-  return b;
-}
-
-Matrix Matrix::operator-(const Matrix& a) const {
-  checkSize(a);
-  Matrix b = *this;
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      b[i][j] -= a[i][j];
-    }
-  }
-  return b;
-}
-
-double Matrix::dotProd(const std::vector<double>& a,
-                       const std::vector<double>& b) const {
-  double result = 0;
-  for (size_t i = 0; i < a.size(); ++i) {
-    result += a[i] * b[i];
-  }
-  return result;
-}
-
-Matrix Matrix::operator*(const Matrix& a) const {
-  if (a.getRowSize() != getColSize()) {
+template <class T>
+BasicMatrix<T> multiply(const BasicConstMatrixView<T>& a,
+                        const BasicConstMatrixView<T>& b) {
+  if (b.getRowSize() != a.getColSize()) {
     throw SizeMismatchException();
   }
-  Matrix result = Matrix(getRowSize(), a.getColSize());
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < a.getColSize(); ++j) {
-      result[i][j] = dotProd(getRowVector(i), a.getColumnVector(j));
-    }
-  }
+  OperationScope scope(Operation::kMultiply, 2.0 * a.getRowSize() *
+                                                 a.getColSize() *
+                                                 b.getColSize());
+  BasicMatrix<T> result(a.getRowSize(), b.getColSize());
+  gemm(a.getRowSize(), b.getColSize(), a.getColSize(), T(1), a.data(),
+       a.getRowStride(), a.getColStride(), b.data(), b.getRowStride(),
+       b.getColStride(), T(), result[0], result.getColSize());
   return result;
 }
 
-Matrix Matrix::operator*(const double& a) const {
-  Matrix b = *this;
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      b[i][j] *= a;
-    }
-  }
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::operator+() const {
+  BasicMatrix b = *this;
   return b;
 }
 
-Matrix Matrix::operator-() const {
-  Matrix b = *this;
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      b[i][j] = -b[i][j];
+// Fields use the blocked LU factorization, integers Bareiss elimination.
+template <class T>
+T BasicMatrix<T>::det() const {
+  if (getRowSize() != getColSize()) {
+    throw SizeMismatchException();
+  }
+  size_t n = getRowSize();
+  OperationScope scope(Operation::kDet, 2.0 / 3 * n * n * n);
+  if constexpr (std::is_integral_v<T>) {
+    return bareissDet(*this);
+  } else {
+    BasicMatrix lu = *this;
+    std::vector<size_t> pivots(n);
+    T result = factorLU(lu[0], n, pivots.data());
+    for (size_t i = 0; i < n; ++i) {
+      result *= lu[i][i];
     }
+    return result;
   }
-  return b;
 }
 
-Matrix Matrix::operator+() const {
-  Matrix b = *this;
-  return b;
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::transposed() const {
+  OperationScope scope(Operation::kTranspose);
+  BasicMatrix transp_mat(getColSize(), getRowSize());
+  transposeCopy(data_, getRowSize(), getColSize(), transp_mat.data_);
+  return transp_mat;
 }
 
-double Matrix::determinant(const Matrix& mat, size_t rows) const {
-  if (rows == 1) {
-    return mat[0][0];
-  } else if (rows == 2) {
-    return mat[0][0] * mat[1][1] - mat[0][1] * mat[1][0];
+template <class T>
+void BasicMatrix<T>::transpose() {
+  OperationScope scope(Operation::kTranspose);
+  if (getRowSize() == getColSize()) {
+    detach();
+    transposeDiagonal(data_, getRowSize(), 0, getRowSize());
+    return;
   }
-  double result = 0;
-  Matrix new_mat = Matrix(rows - 1, rows - 1);
-  for (size_t i = 0; i < rows; ++i) {
-    size_t t = 0;
-    for (size_t j = 0; j < rows; ++j) {
-      if (i == j) continue;
-      for (size_t k = 1; k < rows; ++k) {
-        new_mat[k - 1][t] = mat[k][j];
-      }
-      ++t;
-    }
-    if (i % 2 == 0) {
-      result += mat[0][i] * determinant(new_mat, rows - 1);
+  if (getRowSize() > 1 && getColSize() > 1) {
+    if (isInline()) {
+      T source[kInlineBytes / sizeof(T)];
+      std::copy_n(data_, elementCount(), source);
+      transposeCopy(source, getRowSize(), getColSize(), data_);
     } else {
-      result -= mat[0][i] * determinant(new_mat, rows - 1);
+      T* buffer = allocateBuffer(elementCount());
+      transposeCopy(data_, getRowSize(), getColSize(), buffer);
+      clearMemory();
+      data_ = buffer;
     }
   }
-  return result;
+  std::swap(row_size_, col_size_);
 }
 
-double Matrix::det() const {
+template <class T>
+T BasicMatrix<T>::trace() const {
   if (getRowSize() != getColSize()) {
     throw SizeMismatchException();
   }
-  return determinant(*this, getRowSize());
+  return simd::stridedSum(getRowSize(), data_, getColSize() + 1);
 }
 
-Matrix Matrix::transposed() const {
-  Matrix transp_mat = Matrix(getColSize(), getRowSize());
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      transp_mat[j][i] = data_[i][j];
-    }
-  }
-  return transp_mat;
-}
-
-void Matrix::transpose() { *this = transposed(); }
-
-double Matrix::trace() const {
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::pow(size_t power) const {
   if (getRowSize() != getColSize()) {
     throw SizeMismatchException();
   }
-  double result = 0;
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    result += data_[i][i];
+  size_t n = getRowSize();
+  OperationScope scope(Operation::kPow);
+  BasicMatrix result(n, n);
+  if (power == 0) return result;
+  BasicMatrix base = *this;
+  // A copy-on-write copy still shares this matrix's buffer; once swapped
+  // into spare, writing the product into it would detach on every step.
+  base.detach();
+  BasicMatrix spare(n, n);
+  auto multiplyInto = [n, &scope](const BasicMatrix& a, const BasicMatrix& b,
+                                  BasicMatrix& out) {
+    scope.addFlops(2.0 * n * n * n);
+    gemm(n, n, n, T(1), a.data_, n, 1, b.data_, n, 1, T(), out[0], n);
+  };
+  bool is_identity = true;
+  while (true) {
+    if (power & 1) {
+      if (is_identity) {
+        std::copy_n(base.data_, elementCount(), result.data_);
+        is_identity = false;
+      } else {
+        multiplyInto(result, base, spare);
+        std::swap(result, spare);
+      }
+    }
+    power >>= 1;
+    if (power == 0) break;
+    multiplyInto(base, base, spare);
+    std::swap(base, spare);
   }
   return result;
 }
 
-std::vector<double> Matrix::getRowVector(size_t row) const {
-  std::vector<double> result(getColSize());
+template <class T>
+std::vector<T> BasicMatrix<T>::getRowVector(size_t row) const {
+  std::vector<T> result(getColSize());
   for (size_t j = 0; j < getColSize(); ++j) {
-    result[j] = data_[row][j];
+    result[j] = (*this)[row][j];
   }
   return result;
 }
 
-std::vector<double> Matrix::getColumnVector(size_t column) const {
-  std::vector<double> result(getRowSize());
+template <class T>
+std::vector<T> BasicMatrix<T>::getColumnVector(size_t column) const {
+  std::vector<T> result(getRowSize());
   for (size_t j = 0; j < getRowSize(); ++j) {
-    result[j] = data_[j][column];
+    result[j] = (*this)[j][column];
   }
   return result;
 }
 
-std::vector<double> Matrix::getRow(size_t row) { return getRowVector(row); }
+template <class T>
+std::vector<T> BasicMatrix<T>::getRow(size_t row) {
+  return getRowVector(row);
+}
 
-std::vector<double> Matrix::getColumn(size_t column) {
-  return getColumnVector(column);
+template <class T>
+BasicMatrixView<T> BasicMatrix<T>::rowView(size_t row) {
+  return blockView(row, 0, 1, getColSize());
 }
 
-bool Matrix::operator==(const Matrix& a) const {
-  if (a.getRowSize() != getRowSize() || a.getColSize() != getColSize())
-    return false;
-  for (size_t i = 0; i < getRowSize(); ++i) {
-    for (size_t j = 0; j < getColSize(); ++j) {
-      if (fabs(data_[i][j] - a[i][j]) > EPS) {
-        return false;
-      }
-    }
-  }
-  return true;
+template <class T>
+BasicConstMatrixView<T> BasicMatrix<T>::rowView(size_t row) const {
+  return blockView(row, 0, 1, getColSize());
 }
 
-bool Matrix::operator!=(const Matrix& a) const {
-  if (*this == a) {
-    return false;
-  }
-  return true;
+template <class T>
+BasicMatrixView<T> BasicMatrix<T>::columnView(size_t column) {
+  return blockView(0, column, getRowSize(), 1);
 }
 
-Matrix task::operator*(const double& a, const Matrix& b) { return b * a; }
+template <class T>
+BasicConstMatrixView<T> BasicMatrix<T>::columnView(size_t column) const {
+  return blockView(0, column, getRowSize(), 1);
+}
 
-std::ostream& task::operator<<(std::ostream& output, const Matrix& matrix) {
-  for (size_t i = 0; i < matrix.getRowSize(); ++i) {
-    for (size_t j = 0; j < matrix.getColSize(); ++j) {
-      output << matrix.get(i, j) << " ";
-    }
-  }
-  output << "\n";
-  return output;
-}
-
-std::istream& task::operator>>(std::istream& input, Matrix& matrix) {
-  size_t row;
-  size_t col;
-  input >> row;
-  input >> col;
-  Matrix temp = Matrix(row, col);
-  matrix = temp;
-  for (size_t i = 0; i < row; ++i) {
-    for (size_t j = 0; j < col; ++j) {
-      double value;
-      input >> value;
-      matrix.set(i, j, value);
-    }
-  }
-  return input;
+template <class T>
+BasicMatrixView<T> BasicMatrix<T>::blockView(size_t row, size_t col,
+                                             size_t rows, size_t cols) {
+  return BasicMatrixView<T>(*this).block(row, col, rows, cols);
 }
+
+template <class T>
+BasicConstMatrixView<T> BasicMatrix<T>::blockView(size_t row, size_t col,
+                                                  size_t rows,
+                                                  size_t cols) const {
+  return BasicConstMatrixView<T>(*this).block(row, col, rows, cols);
+}
+
+template <class T>
+std::vector<T> BasicMatrix<T>::getColumn(size_t column) {
+  return getColumnVector(column);
+}
+
+template class BasicMatrix<float>;
+template class BasicMatrix<double>;
+template class BasicMatrix<int64_t>;
+template class BasicMatrix<std::complex<double>>;
+
+template BasicMatrix<float> multiply(const BasicConstMatrixView<float>&,
+                                     const BasicConstMatrixView<float>&);
+template BasicMatrix<double> multiply(const BasicConstMatrixView<double>&,
+                                      const BasicConstMatrixView<double>&);
+template BasicMatrix<int64_t> multiply(const BasicConstMatrixView<int64_t>&,
+                                       const BasicConstMatrixView<int64_t>&);
+template BasicMatrix<std::complex<double>> multiply(
+    const BasicConstMatrixView<std::complex<double>>&,
+    const BasicConstMatrixView<std::complex<double>>&);
+
+}  // namespace task
@@ -1,79 +1,742 @@
 #pragma once
 
 #include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <memory_resource>
+#include <type_traits>
 #include <vector>
 
+#include "instrumentation.h"
+#include "simd.h"
+
 namespace task {
 
-const double EPS = 1e-6;
+constexpr double EPS = 1e-6;
+const size_t kMatrixAlignment = 64;
 
 class OutOfBoundsException : public std::exception {};
 class SizeMismatchException : public std::exception {};
 
-class Matrix {
+// Resource that matrices created on the calling thread allocate from:
+// std::pmr::get_default_resource() unless a MatrixResourceScope is active.
+std::pmr::memory_resource* getMatrixResource();
+
+// While alive, sends the buffers of every matrix created on the calling
+// thread, temporaries included, to resource, e.g. an arena that releases a
+// whole computation at once. Scopes nest. Each thread has its own scope, so
+// an unsynchronized resource is never shared between threads. A matrix keeps
+// the resource it was created with and must not outlive it.
+class MatrixResourceScope {
  public:
-  Matrix();
-  Matrix(size_t rows, size_t cols);
-  Matrix(const Matrix& copy);
-  Matrix& operator=(const Matrix& a);
-
-  double& get(size_t row, size_t col);
-  const double& get(size_t row, size_t col) const;
-  void set(size_t row, size_t col, const double& value);
-  void resize(size_t new_rows, size_t new_cols);
+  explicit MatrixResourceScope(std::pmr::memory_resource* resource);
+  MatrixResourceScope(const MatrixResourceScope&) = delete;
+  MatrixResourceScope& operator=(const MatrixResourceScope&) = delete;
+  ~MatrixResourceScope();
+
+ private:
+  std::pmr::memory_resource* previous_;
+};
+
+template <class T>
+class BasicMatrix;
+template <class T>
+class BasicMatrixView;
+template <class T>
+class BasicConstMatrixView;
+
+using Matrix = BasicMatrix<double>;
+using MatrixView = BasicMatrixView<double>;
+using ConstMatrixView = BasicConstMatrixView<double>;
+
+// Largest elementwise difference operator== accepts: EPS for double
+// precision, a bound scaled to float precision for float, none for integers.
+template <class T>
+constexpr double tolerance() {
+  using Magnitude = decltype(std::abs(T()));
+  if constexpr (std::is_integral_v<Magnitude>) {
+    return 0.0;
+  } else if constexpr (std::is_same_v<Magnitude, float>) {
+    return 1e-4;
+  } else {
+    return EPS;
+  }
+}
+
+// Base of every elementwise matrix expression. An expression is a node that
+// knows its shape and element type (E::Scalar) and can produce any element
+// through coeff(); nothing is computed until it is assigned to a matrix.
+template <class E>
+class MatrixExpr {
+ public:
+  const E& derived() const { return static_cast<const E&>(*this); }
+
+  auto eval() const;
+};
+
+// Dense matrix of T. Instantiated for float, double, int64_t and
+// std::complex<double>.
+//
+// Matrices of at most kInlineBytes keep their elements inside the object and
+// never touch the allocator. Moving such a matrix copies its elements, so
+// pointers and views into it do not follow it.
+//
+// Built with -DMATRIX_COPY_ON_WRITE, copies share a reference-counted buffer
+// with a source whose memory resource compares equal to theirs, until one of
+// them is written through operator[], get, set, a writable view or a
+// compound assignment.
+// The const operator[] never detaches, so writes through it, or through a
+// pointer or view taken before the copy, reach every sharer.
+template <class T>
+class BasicMatrix : public MatrixExpr<BasicMatrix<T>> {
+ public:
+  using Scalar = T;
+
+  BasicMatrix();
+  BasicMatrix(size_t rows, size_t cols);
+  BasicMatrix(size_t rows, size_t cols, std::pmr::memory_resource* resource);
+  // Copies allocate from getMatrixResource(); moves keep their resource.
+  BasicMatrix(const BasicMatrix& copy);
+  BasicMatrix(BasicMatrix&& other) noexcept;
+  template <class E>
+  BasicMatrix(const MatrixExpr<E>& expr);
+  template <class E>
+  BasicMatrix(const MatrixExpr<E>& expr, std::pmr::memory_resource* resource);
+  // Assignment keeps this matrix's resource, as std::pmr containers do: a
+  // move takes over a's buffer only if the resources compare equal and
+  // copies the elements otherwise.
+  BasicMatrix& operator=(const BasicMatrix& a);
+  BasicMatrix& operator=(BasicMatrix&& a);
+  // expr may read this matrix through views, e.g. m = m.blockView(...) or
+  // m = ConstMatrixView(m).transposed(): it is then evaluated into a new
+  // buffer, which replaces the old one afterwards.
+  template <class E>
+  BasicMatrix& operator=(const MatrixExpr<E>& expr);
 
-  double* operator[](size_t row);
-  double* operator[](size_t row) const;
+  T& get(size_t row, size_t col);
+  const T& get(size_t row, size_t col) const;
+  void set(size_t row, size_t col, const T& value);
+  void resize(size_t new_rows, size_t new_cols);
 
-  Matrix& operator+=(const Matrix& a);
-  Matrix& operator-=(const Matrix& a);
-  Matrix& operator*=(const Matrix& a);
-  Matrix& operator*=(const double& number);
+  T* operator[](size_t row);
+  T* operator[](size_t row) const;
+  T coeff(size_t row, size_t col) const { return data_[row * col_size_ + col]; }
 
-  Matrix operator+(const Matrix& a) const;
-  Matrix operator-(const Matrix& a) const;
-  Matrix operator*(const Matrix& a) const;
-  Matrix operator*(const double& a) const;
+  BasicMatrix& operator+=(const BasicMatrix& a);
+  BasicMatrix& operator-=(const BasicMatrix& a);
+  BasicMatrix& operator*=(const BasicMatrix& a);
+  BasicMatrix& operator*=(const T& number);
+  template <class E>
+  BasicMatrix& operator+=(const MatrixExpr<E>& a);
+  template <class E>
+  BasicMatrix& operator-=(const MatrixExpr<E>& a);
 
-  Matrix operator-() const;
-  Matrix operator+() const;
+  BasicMatrix operator+() const;
 
-  double det() const;
+  // Integer matrices use fraction-free elimination, so their determinant is
+  // exact as long as it fits in T.
+  T det() const;
   void transpose();
-  Matrix transposed() const;
-  double trace() const;
+  BasicMatrix transposed() const;
+  T trace() const;
+  // this^power by repeated squaring: O(log power) products, each written into
+  // a spare buffer that is swapped in, so nothing is allocated past setup.
+  BasicMatrix pow(size_t power) const;
 
-  std::vector<double> getRow(size_t row);
-  std::vector<double> getColumn(size_t column);
+  std::vector<T> getRow(size_t row);
+  std::vector<T> getColumn(size_t column);
 
-  bool operator==(const Matrix& a) const;
-  bool operator!=(const Matrix& a) const;
+  BasicMatrixView<T> rowView(size_t row);
+  BasicConstMatrixView<T> rowView(size_t row) const;
+  BasicMatrixView<T> columnView(size_t column);
+  BasicConstMatrixView<T> columnView(size_t column) const;
+  BasicMatrixView<T> blockView(size_t row, size_t col, size_t rows,
+                               size_t cols);
+  BasicConstMatrixView<T> blockView(size_t row, size_t col, size_t rows,
+                                    size_t cols) const;
 
-  ~Matrix();
+  ~BasicMatrix();
   size_t getRowSize() const;
   size_t getColSize() const;
+  std::pmr::memory_resource* getResource() const;
+
+  static constexpr size_t kInlineBytes = 128;
 
  protected:
-  double** data_;
+  std::pmr::memory_resource* resource_ = getMatrixResource();
+  // Row-major, kMatrixAlignment-aligned buffer of row_size_ * col_size_:
+  // inline_buffer_ if it fits there, otherwise taken from resource_.
+  T* data_;
   size_t row_size_;
   size_t col_size_;
+  alignas(kMatrixAlignment) unsigned char inline_buffer_[kInlineBytes];
+  T* inlineBuffer();
+  bool isInline() const;
+  T* allocateBuffer(size_t size);
+  void freeBuffer(T* buffer, size_t size) const;
+  // Takes over other's elements, leaving it empty. The matrix must not hold
+  // a buffer, and its resource must be able to free other's.
+  void takeBuffer(BasicMatrix& other) noexcept;
+  size_t elementCount() const;
   void clearMemory();
-  void copyMatrix(const Matrix& a);
-  double dotProd(const std::vector<double>& a,
-                 const std::vector<double>& b) const;
-  double determinant(const Matrix& mat, size_t rows) const;
+  void copyMatrix(const BasicMatrix& a);
+  // Gives the matrix a buffer of its own before a write.
+  void detach();
   void checkBounds(size_t row, size_t col) const;
-  void checkSize(const Matrix& a) const;
-  std::vector<double> getRowVector(size_t row) const;
-  std::vector<double> getColumnVector(size_t column) const;
+  void checkSize(const BasicMatrix& a) const;
+  template <class E, class Op>
+  void evaluate(const E& expr, Op op);
+  template <class E>
+  void assign(const E& expr);
+  std::vector<T> getRowVector(size_t row) const;
+  std::vector<T> getColumnVector(size_t column) const;
   void setRowSize(size_t size);
   void setColSize(size_t size);
 };
 
-Matrix operator*(const double& a, const Matrix& b);
+extern template class BasicMatrix<float>;
+extern template class BasicMatrix<double>;
+extern template class BasicMatrix<int64_t>;
+extern template class BasicMatrix<std::complex<double>>;
+
+// Matrices are held by reference inside expressions, intermediate nodes by
+// value. An expression must therefore not outlive the matrices it names.
+template <class E>
+struct ExprStorage {
+  using type = const E;
+};
+
+template <class T>
+struct ExprStorage<BasicMatrix<T>> {
+  using type = const BasicMatrix<T>&;
+};
+
+template <class L, class R>
+constexpr void checkSameScalar() {
+  static_assert(std::is_same_v<typename L::Scalar, typename R::Scalar>,
+                "matrix operands must have the same element type");
+}
+
+template <class L, class R>
+void checkSameSize(const L& lhs, const R& rhs) {
+  if (lhs.getRowSize() != rhs.getRowSize() ||
+      lhs.getColSize() != rhs.getColSize()) {
+    throw SizeMismatchException();
+  }
+}
+
+template <class L, class R, class Op>
+class MatrixBinaryExpr : public MatrixExpr<MatrixBinaryExpr<L, R, Op>> {
+ public:
+  using Scalar = typename L::Scalar;
+
+  MatrixBinaryExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+    checkSameScalar<L, R>();
+    checkSameSize(lhs, rhs);
+  }
+
+  size_t getRowSize() const { return lhs_.getRowSize(); }
+  size_t getColSize() const { return lhs_.getColSize(); }
+  Scalar coeff(size_t row, size_t col) const {
+    return Op()(lhs_.coeff(row, col), rhs_.coeff(row, col));
+  }
+  const L& lhs() const { return lhs_; }
+  const R& rhs() const { return rhs_; }
+
+ private:
+  typename ExprStorage<L>::type lhs_;
+  typename ExprStorage<R>::type rhs_;
+};
+
+template <class E>
+class MatrixScaled : public MatrixExpr<MatrixScaled<E>> {
+ public:
+  using Scalar = typename E::Scalar;
+
+  MatrixScaled(const E& expr, Scalar factor) : expr_(expr), factor_(factor) {}
+
+  size_t getRowSize() const { return expr_.getRowSize(); }
+  size_t getColSize() const { return expr_.getColSize(); }
+  Scalar coeff(size_t row, size_t col) const {
+    return expr_.coeff(row, col) * factor_;
+  }
+  const E& expr() const { return expr_; }
+  Scalar factor() const { return factor_; }
+
+ private:
+  typename ExprStorage<E>::type expr_;
+  Scalar factor_;
+};
+
+template <class E>
+class MatrixNegated : public MatrixExpr<MatrixNegated<E>> {
+ public:
+  using Scalar = typename E::Scalar;
+
+  explicit MatrixNegated(const E& expr) : expr_(expr) {}
+
+  size_t getRowSize() const { return expr_.getRowSize(); }
+  size_t getColSize() const { return expr_.getColSize(); }
+  Scalar coeff(size_t row, size_t col) const { return -expr_.coeff(row, col); }
+  const E& expr() const { return expr_; }
+
+ private:
+  typename ExprStorage<E>::type expr_;
+};
+
+// Arithmetic operations an expression performs per element, for the
+// instrumentation counters.
+template <class E>
+struct ExprFlops : std::integral_constant<size_t, 0> {};
+
+template <class L, class R, class Op>
+struct ExprFlops<MatrixBinaryExpr<L, R, Op>>
+    : std::integral_constant<size_t, 1 + ExprFlops<L>::value +
+                                         ExprFlops<R>::value> {};
+
+template <class E>
+struct ExprFlops<MatrixScaled<E>>
+    : std::integral_constant<size_t, 1 + ExprFlops<E>::value> {};
+
+template <class E>
+struct ExprFlops<MatrixNegated<E>>
+    : std::integral_constant<size_t, 1 + ExprFlops<E>::value> {};
+
+// Non-owning window onto matrix storage: element (i, j) lives at
+// data[i * row_stride + j * col_stride]. Rows, columns, blocks and transposes
+// of a matrix are all views with different strides. A view is invalidated by
+// anything that reallocates the matrix it looks into.
+template <class T>
+class BasicConstMatrixView : public MatrixExpr<BasicConstMatrixView<T>> {
+ public:
+  using Scalar = T;
+
+  BasicConstMatrixView(const T* data, size_t rows, size_t cols,
+                       size_t row_stride, size_t col_stride)
+      : data_(data),
+        row_size_(rows),
+        col_size_(cols),
+        row_stride_(row_stride),
+        col_stride_(col_stride) {}
+  BasicConstMatrixView(const BasicMatrix<T>& matrix)
+      : BasicConstMatrixView(matrix[0], matrix.getRowSize(),
+                             matrix.getColSize(), matrix.getColSize(), 1) {}
+
+  size_t getRowSize() const { return row_size_; }
+  size_t getColSize() const { return col_size_; }
+  size_t getRowStride() const { return row_stride_; }
+  size_t getColStride() const { return col_stride_; }
+  const T* data() const { return data_; }
+
+  T coeff(size_t row, size_t col) const {
+    return data_[row * row_stride_ + col * col_stride_];
+  }
+  const T& get(size_t row, size_t col) const {
+    checkViewBounds(row, col, 1, 1);
+    return data_[row * row_stride_ + col * col_stride_];
+  }
+
+  BasicConstMatrixView block(size_t row, size_t col, size_t rows,
+                             size_t cols) const {
+    checkViewBounds(row, col, rows, cols);
+    return BasicConstMatrixView(data_ + row * row_stride_ + col * col_stride_,
+                                rows, cols, row_stride_, col_stride_);
+  }
+  BasicConstMatrixView transposed() const {
+    return BasicConstMatrixView(data_, col_size_, row_size_, col_stride_,
+                                row_stride_);
+  }
+
+ protected:
+  void checkViewBounds(size_t row, size_t col, size_t rows,
+                       size_t cols) const {
+    if (row + rows > row_size_ || col + cols > col_size_) {
+      throw OutOfBoundsException();
+    }
+  }
+
+  const T* data_;
+  size_t row_size_;
+  size_t col_size_;
+  size_t row_stride_;
+  size_t col_stride_;
+};
+
+// Writable view. Assigning to a view writes through to the viewed elements;
+// the source must not overlap the view unless it is the very same elements.
+template <class T>
+class BasicMatrixView : public MatrixExpr<BasicMatrixView<T>> {
+ public:
+  using Scalar = T;
+
+  BasicMatrixView(T* data, size_t rows, size_t cols, size_t row_stride,
+                  size_t col_stride)
+      : data_(data),
+        row_size_(rows),
+        col_size_(cols),
+        row_stride_(row_stride),
+        col_stride_(col_stride) {}
+  BasicMatrixView(BasicMatrix<T>& matrix)
+      : BasicMatrixView(matrix[0], matrix.getRowSize(), matrix.getColSize(),
+                        matrix.getColSize(), 1) {}
+  BasicMatrixView(const BasicMatrixView& other) = default;
+
+  BasicMatrixView& operator=(const BasicMatrixView& other) {
+    return *this = static_cast<const MatrixExpr<BasicMatrixView>&>(other);
+  }
+  template <class E>
+  BasicMatrixView& operator=(const MatrixExpr<E>& expr) {
+    checkSameScalar<BasicMatrixView, E>();
+    checkSameSize(*this, expr.derived());
+    evaluate(expr.derived(), [](T& target, T value) { target = value; });
+    return *this;
+  }
+  template <class E>
+  BasicMatrixView& operator+=(const MatrixExpr<E>& expr) {
+    checkSameScalar<BasicMatrixView, E>();
+    checkSameSize(*this, expr.derived());
+    evaluate(expr.derived(), [](T& target, T value) { target += value; });
+    return *this;
+  }
+  template <class E>
+  BasicMatrixView& operator-=(const MatrixExpr<E>& expr) {
+    checkSameScalar<BasicMatrixView, E>();
+    checkSameSize(*this, expr.derived());
+    evaluate(expr.derived(), [](T& target, T value) { target -= value; });
+    return *this;
+  }
+  BasicMatrixView& operator*=(const T& number) {
+    for (size_t i = 0; i < row_size_; ++i) {
+      for (size_t j = 0; j < col_size_; ++j) {
+        coeffRef(i, j) *= number;
+      }
+    }
+    return *this;
+  }
+
+  operator BasicConstMatrixView<T>() const {
+    return BasicConstMatrixView<T>(data_, row_size_, col_size_, row_stride_,
+                                   col_stride_);
+  }
+
+  size_t getRowSize() const { return row_size_; }
+  size_t getColSize() const { return col_size_; }
+  size_t getRowStride() const { return row_stride_; }
+  size_t getColStride() const { return col_stride_; }
+  T* data() const { return data_; }
+
+  T coeff(size_t row, size_t col) const {
+    return data_[row * row_stride_ + col * col_stride_];
+  }
+  T& coeffRef(size_t row, size_t col) const {
+    return data_[row * row_stride_ + col * col_stride_];
+  }
+  T& get(size_t row, size_t col) const {
+    checkViewBounds(row, col, 1, 1);
+    return coeffRef(row, col);
+  }
+  void set(size_t row, size_t col, const T& value) const {
+    get(row, col) = value;
+  }
+
+  BasicMatrixView block(size_t row, size_t col, size_t rows,
+                        size_t cols) const {
+    checkViewBounds(row, col, rows, cols);
+    return BasicMatrixView(data_ + row * row_stride_ + col * col_stride_, rows,
+                           cols, row_stride_, col_stride_);
+  }
+  BasicMatrixView transposed() const {
+    return BasicMatrixView(data_, col_size_, row_size_, col_stride_,
+                           row_stride_);
+  }
+
+ protected:
+  void checkViewBounds(size_t row, size_t col, size_t rows,
+                       size_t cols) const {
+    if (row + rows > row_size_ || col + cols > col_size_) {
+      throw OutOfBoundsException();
+    }
+  }
+  template <class E, class Op>
+  void evaluate(const E& expr, Op op) {
+    for (size_t i = 0; i < row_size_; ++i) {
+      for (size_t j = 0; j < col_size_; ++j) {
+        op(coeffRef(i, j), expr.coeff(i, j));
+      }
+    }
+  }
+
+  T* data_;
+  size_t row_size_;
+  size_t col_size_;
+  size_t row_stride_;
+  size_t col_stride_;
+};
+
+// Whether evaluating an expression may read any element in [begin, end).
+// Matrices are read element by element in step with the destination, so only
+// views, which can be shifted or transposed, count. Every expression leaf
+// needs an overload.
+template <class T>
+bool readsFrom(const BasicMatrix<T>&, const T*, const T*) {
+  return false;
+}
+
+template <class T>
+bool readsFrom(const BasicConstMatrixView<T>& view, const T* begin,
+               const T* end) {
+  if (view.getRowSize() == 0 || view.getColSize() == 0) return false;
+  const T* first = view.data();
+  const T* last = first + (view.getRowSize() - 1) * view.getRowStride() +
+                  (view.getColSize() - 1) * view.getColStride();
+  std::less<const T*> less;
+  return !less(last, begin) && less(first, end);
+}
+
+template <class T>
+bool readsFrom(const BasicMatrixView<T>& view, const T* begin,
+               const T* end) {
+  return readsFrom(BasicConstMatrixView<T>(view), begin, end);
+}
+
+template <class L, class R, class Op, class T>
+bool readsFrom(const MatrixBinaryExpr<L, R, Op>& expr, const T* begin,
+               const T* end) {
+  return readsFrom(expr.lhs(), begin, end) ||
+         readsFrom(expr.rhs(), begin, end);
+}
+
+template <class E, class T>
+bool readsFrom(const MatrixScaled<E>& expr, const T* begin, const T* end) {
+  return readsFrom(expr.expr(), begin, end);
+}
+
+template <class E, class T>
+bool readsFrom(const MatrixNegated<E>& expr, const T* begin, const T* end) {
+  return readsFrom(expr.expr(), begin, end);
+}
+
+template <class L, class R>
+using MatrixSum = MatrixBinaryExpr<L, R, std::plus<typename L::Scalar>>;
+
+template <class L, class R>
+using MatrixDifference =
+    MatrixBinaryExpr<L, R, std::minus<typename L::Scalar>>;
+
+template <class L, class R>
+MatrixSum<L, R> operator+(const MatrixExpr<L>& a, const MatrixExpr<R>& b) {
+  return MatrixSum<L, R>(a.derived(), b.derived());
+}
+
+template <class L, class R>
+MatrixDifference<L, R> operator-(const MatrixExpr<L>& a,
+                                 const MatrixExpr<R>& b) {
+  return MatrixDifference<L, R>(a.derived(), b.derived());
+}
+
+template <class E>
+MatrixScaled<E> operator*(const MatrixExpr<E>& a,
+                          const typename E::Scalar& number) {
+  return MatrixScaled<E>(a.derived(), number);
+}
+
+template <class E>
+MatrixScaled<E> operator*(const typename E::Scalar& number,
+                          const MatrixExpr<E>& a) {
+  return MatrixScaled<E>(a.derived(), number);
+}
+
+template <class E>
+MatrixNegated<E> operator-(const MatrixExpr<E>& a) {
+  return MatrixNegated<E>(a.derived());
+}
+
+template <class E>
+const E& operator+(const MatrixExpr<E>& a) {
+  return a.derived();
+}
+
+// Product of two strided operands through the packed gemm kernel.
+template <class T>
+BasicMatrix<T> multiply(const BasicConstMatrixView<T>& a,
+                        const BasicConstMatrixView<T>& b);
+
+template <class T>
+const BasicMatrix<T>& evaluated(const BasicMatrix<T>& a) {
+  return a;
+}
+
+template <class T>
+const BasicMatrixView<T>& evaluated(const BasicMatrixView<T>& a) {
+  return a;
+}
+
+template <class T>
+const BasicConstMatrixView<T>& evaluated(const BasicConstMatrixView<T>& a) {
+  return a;
+}
+
+template <class E>
+auto evaluated(const MatrixExpr<E>& a) {
+  return a.eval();
+}
+
+// Matrix products are not elementwise: matrices and views are multiplied in
+// place, other expression operands are evaluated first.
+template <class L, class R>
+BasicMatrix<typename L::Scalar> operator*(const MatrixExpr<L>& a,
+                                          const MatrixExpr<R>& b) {
+  checkSameScalar<L, R>();
+  return multiply<typename L::Scalar>(evaluated(a.derived()),
+                                      evaluated(b.derived()));
+}
+
+template <class L, class R>
+bool operator==(const MatrixExpr<L>& a, const MatrixExpr<R>& b) {
+  using Scalar = typename L::Scalar;
+  checkSameScalar<L, R>();
+  const L& lhs = a.derived();
+  const R& rhs = b.derived();
+  if (lhs.getRowSize() != rhs.getRowSize() ||
+      lhs.getColSize() != rhs.getColSize()) {
+    return false;
+  }
+  if constexpr (std::is_same_v<L, BasicMatrix<Scalar>> &&
+                std::is_same_v<R, BasicMatrix<Scalar>>) {
+    return simd::allClose(lhs.getRowSize() * lhs.getColSize(), lhs[0], rhs[0],
+                          tolerance<Scalar>());
+  } else {
+    for (size_t i = 0; i < lhs.getRowSize(); ++i) {
+      for (size_t j = 0; j < lhs.getColSize(); ++j) {
+        if (std::abs(lhs.coeff(i, j) - rhs.coeff(i, j)) > tolerance<Scalar>()) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
+
+template <class L, class R>
+bool operator!=(const MatrixExpr<L>& a, const MatrixExpr<R>& b) {
+  return !(a == b);
+}
+
+template <class E>
+auto MatrixExpr<E>::eval() const {
+  return BasicMatrix<typename E::Scalar>(*this);
+}
+
+template <class T>
+template <class E, class Op>
+void BasicMatrix<T>::evaluate(const E& expr, Op op) {
+  for (size_t i = 0; i < getRowSize(); ++i) {
+    T* row = (*this)[i];
+    for (size_t j = 0; j < getColSize(); ++j) {
+      op(row[j], expr.coeff(i, j));
+    }
+  }
+}
+
+// Single-operation expressions over plain matrices go to the vectorized
+// kernels; everything else is fused into one generic loop.
+template <class T>
+template <class E>
+void BasicMatrix<T>::assign(const E& expr) {
+  checkSameScalar<BasicMatrix, E>();
+  size_t size = elementCount();
+  if constexpr (std::is_same_v<E, MatrixSum<BasicMatrix, BasicMatrix>>) {
+    simd::add(size, expr.lhs().data_, expr.rhs().data_, data_);
+  } else if constexpr (std::is_same_v<E, MatrixDifference<BasicMatrix,
+                                                          BasicMatrix>>) {
+    simd::subtract(size, expr.lhs().data_, expr.rhs().data_, data_);
+  } else if constexpr (std::is_same_v<E, MatrixScaled<BasicMatrix>>) {
+    simd::scale(size, expr.factor(), expr.expr().data_, data_);
+  } else if constexpr (std::is_same_v<E, MatrixNegated<BasicMatrix>>) {
+    simd::negate(size, expr.expr().data_, data_);
+  } else {
+    evaluate(expr, [](T& target, T value) { target = value; });
+  }
+}
+
+template <class T>
+template <class E>
+BasicMatrix<T>::BasicMatrix(const MatrixExpr<E>& expr)
+    : BasicMatrix(expr, getMatrixResource()) {}
+
+template <class T>
+template <class E>
+BasicMatrix<T>::BasicMatrix(const MatrixExpr<E>& expr,
+                            std::pmr::memory_resource* resource)
+    : resource_(resource),
+      row_size_(expr.derived().getRowSize()),
+      col_size_(expr.derived().getColSize()) {
+  recordTemporary();
+  OperationScope scope(Operation::kEvaluate,
+                       double(elementCount()) * ExprFlops<E>::value);
+  data_ = allocateBuffer(elementCount());
+  assign(expr.derived());
+}
+
+template <class T>
+template <class E>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const MatrixExpr<E>& expr) {
+  const E& source = expr.derived();
+  size_t size = source.getRowSize() * source.getColSize();
+  OperationScope scope(Operation::kEvaluate,
+                       double(size) * ExprFlops<E>::value);
+  if (size != elementCount() ||
+      readsFrom(source, data_, data_ + elementCount())) {
+    return *this = BasicMatrix(source, resource_);
+  }
+  detach();
+  setRowSize(source.getRowSize());
+  setColSize(source.getColSize());
+  assign(source);
+  return *this;
+}
+
+template <class T>
+template <class E>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const MatrixExpr<E>& a) {
+  checkSameScalar<BasicMatrix, E>();
+  checkSameSize(*this, a.derived());
+  if (readsFrom(a.derived(), data_, data_ + elementCount())) {
+    return *this += BasicMatrix(a);
+  }
+  OperationScope scope(Operation::kEvaluate,
+                       double(elementCount()) * (ExprFlops<E>::value + 1));
+  detach();
+  evaluate(a.derived(), [](T& target, T value) { target += value; });
+  return *this;
+}
+
+template <class T>
+template <class E>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const MatrixExpr<E>& a) {
+  checkSameScalar<BasicMatrix, E>();
+  checkSameSize(*this, a.derived());
+  if (readsFrom(a.derived(), data_, data_ + elementCount())) {
+    return *this -= BasicMatrix(a);
+  }
+  OperationScope scope(Operation::kEvaluate,
+                       double(elementCount()) * (ExprFlops<E>::value + 1));
+  detach();
+  evaluate(a.derived(), [](T& target, T value) { target -= value; });
+  return *this;
+}
+
+template <class T>
+std::ostream& operator<<(std::ostream& output, const BasicMatrix<T>& matrix);
+template <class T>
+std::istream& operator>>(std::istream& input, BasicMatrix<T>& matrix);
 
-std::ostream& operator<<(std::ostream& output, const Matrix& matrix);
-std::istream& operator>>(std::istream& input, Matrix& matrix);
+template <class E>
+std::ostream& operator<<(std::ostream& output, const MatrixExpr<E>& expr) {
+  return output << expr.eval();
+}
 
 }  // namespace task
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "fixed_matrix.h"
+#include "thread_pool.h"
+
+namespace task {
+
+// Many N x N matrices in structure-of-arrays layout: element (row, col) of
+// every matrix is stored contiguously in one plane, so the kernels below run
+// the same closed-form arithmetic over consecutive matrices and vectorize
+// across the batch. Work is split into blocks of kBlock matrices that are
+// spread over the thread pool. A new batch holds identity matrices.
+template <size_t N, class T = double>
+class MatrixBatch {
+  static_assert(std::is_arithmetic_v<T>, "elements must be real numbers");
+
+ public:
+  using Matrix = FixedMatrix<N, N, T>;
+
+  explicit MatrixBatch(size_t size = 0)
+      : data_(allocateBuffer(planeStride(size))),
+        size_(size),
+        stride_(planeStride(size)) {
+    fillIdentity(0, size);
+  }
+  MatrixBatch(const MatrixBatch& other)
+      : data_(allocateBuffer(other.stride_)),
+        size_(other.size_),
+        stride_(other.stride_) {
+    std::copy_n(other.data_, N * N * stride_, data_);
+  }
+  MatrixBatch(MatrixBatch&& other) noexcept
+      : data_(other.data_), size_(other.size_), stride_(other.stride_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.stride_ = 0;
+  }
+  MatrixBatch& operator=(const MatrixBatch& other) {
+    if (this != &other) {
+      *this = MatrixBatch(other);
+    }
+    return *this;
+  }
+  MatrixBatch& operator=(MatrixBatch&& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(stride_, other.stride_);
+    return *this;
+  }
+  ~MatrixBatch() { freeBuffer(data_); }
+
+  size_t size() const { return size_; }
+  // Keeps the first min(size(), size) matrices; new ones are identities.
+  void resize(size_t size) {
+    if (size == size_) return;
+    MatrixBatch result(size);
+    size_t kept = std::min(size, size_);
+    for (size_t p = 0; p < N * N; ++p) {
+      std::copy_n(data_ + p * stride_, kept,
+                  result.data_ + p * result.stride_);
+    }
+    *this = std::move(result);
+  }
+
+  Matrix get(size_t index) const {
+    checkIndex(index);
+    return load(index);
+  }
+  void set(size_t index, const Matrix& matrix) {
+    checkIndex(index);
+    store(index, matrix);
+  }
+
+  // Element (row, col) of every matrix: plane(row, col)[index].
+  T* plane(size_t row, size_t col) {
+    return data_ + (row * N + col) * stride_;
+  }
+  const T* plane(size_t row, size_t col) const {
+    return data_ + (row * N + col) * stride_;
+  }
+
+  // out[i] = (*this)[i] * other[i]. out is resized and may be either operand.
+  void multiply(const MatrixBatch& other, MatrixBatch& out) const {
+    if (other.size_ != size_) {
+      throw SizeMismatchException();
+    }
+    if (&out == this || &out == &other) {
+      MatrixBatch result;
+      multiply(other, result);
+      out = std::move(result);
+      return;
+    }
+    out.resize(size_);
+    forEachBlock([&](size_t begin, size_t end) {
+      for (size_t i = 0; i < N; ++i) {
+        for (size_t j = 0; j < N; ++j) {
+          const T* row[N];
+          const T* col[N];
+          for (size_t l = 0; l < N; ++l) {
+            row[l] = plane(i, l);
+            col[l] = other.plane(l, j);
+          }
+          T* __restrict target = out.plane(i, j);
+          for (size_t k = begin; k < end; ++k) {
+            T sum = row[0][k] * col[0][k];
+            for (size_t l = 1; l < N; ++l) {
+              sum += row[l][k] * col[l][k];
+            }
+            target[k] = sum;
+          }
+        }
+      }
+    });
+  }
+
+  // A transpose only permutes the planes.
+  void transpose(MatrixBatch& out) const {
+    if (&out == this) {
+      for (size_t i = 0; i < N; ++i) {
+        for (size_t j = i + 1; j < N; ++j) {
+          std::swap_ranges(out.plane(i, j), out.plane(i, j) + size_,
+                           out.plane(j, i));
+        }
+      }
+      return;
+    }
+    out.resize(size_);
+    for (size_t i = 0; i < N; ++i) {
+      for (size_t j = 0; j < N; ++j) {
+        std::copy_n(plane(i, j), size_, out.plane(j, i));
+      }
+    }
+  }
+
+  // out[i] = det((*this)[i]) for every matrix.
+  void det(T* out) const {
+    forEachBlock([&](size_t begin, size_t end) {
+      for (size_t k = begin; k < end; ++k) {
+        out[k] = load(k).det();
+      }
+    });
+  }
+
+  // Adjugate over determinant, one cofactor plane at a time. Throws
+  // SingularMatrixException, leaving out unspecified, if any matrix is
+  // singular.
+  void inverse(MatrixBatch& out) const {
+    static_assert(std::is_floating_point_v<T>, "inverse needs a field");
+    if (&out == this) {
+      MatrixBatch result;
+      inverse(result);
+      out = std::move(result);
+      return;
+    }
+    out.resize(size_);
+    forEachBlock([&](size_t begin, size_t end) {
+      T reciprocal[kBlock];
+      bool singular = false;
+      for (size_t k = begin; k < end; ++k) {
+        T determinant = load(k).det();
+        singular |= determinant == T();
+        reciprocal[k - begin] = T(1) / determinant;
+      }
+      if (singular) {
+        throw SingularMatrixException();
+      }
+      if constexpr (N == 1) {
+        std::copy_n(reciprocal, end - begin, out.plane(0, 0) + begin);
+      } else {
+        for (size_t i = 0; i < N; ++i) {
+          for (size_t j = 0; j < N; ++j) {
+            inverseCofactors(i, j, begin, end, reciprocal, out.plane(j, i));
+          }
+        }
+      }
+    });
+  }
+
+  MatrixBatch operator*(const MatrixBatch& other) const {
+    MatrixBatch result;
+    multiply(other, result);
+    return result;
+  }
+  MatrixBatch transposed() const {
+    MatrixBatch result;
+    transpose(result);
+    return result;
+  }
+  MatrixBatch inverse() const {
+    MatrixBatch result;
+    inverse(result);
+    return result;
+  }
+  std::vector<T> det() const {
+    std::vector<T> result(size_);
+    det(result.data());
+    return result;
+  }
+
+ private:
+  // Matrices per task: the planes of a block fit in L1 for N <= 4.
+  static const size_t kBlock = 256;
+
+  static size_t planeStride(size_t size) {
+    size_t step = kMatrixAlignment / sizeof(T);
+    return (size + step - 1) / step * step;
+  }
+  static T* allocateBuffer(size_t stride) {
+    size_t bytes = std::max(N * N * stride, size_t(1)) * sizeof(T);
+    return static_cast<T*>(
+        ::operator new(bytes, std::align_val_t(kMatrixAlignment)));
+  }
+  static void freeBuffer(T* buffer) {
+    ::operator delete(buffer, std::align_val_t(kMatrixAlignment));
+  }
+
+  void checkIndex(size_t index) const {
+    if (index >= size_) {
+      throw OutOfBoundsException();
+    }
+  }
+
+  void fillIdentity(size_t begin, size_t end) {
+    for (size_t i = 0; i < N; ++i) {
+      for (size_t j = 0; j < N; ++j) {
+        std::fill(plane(i, j) + begin, plane(i, j) + end,
+                  i == j ? T(1) : T());
+      }
+    }
+  }
+
+  Matrix load(size_t index) const {
+    Matrix matrix;
+    for (size_t i = 0; i < N; ++i) {
+      for (size_t j = 0; j < N; ++j) {
+        matrix[i][j] = plane(i, j)[index];
+      }
+    }
+    return matrix;
+  }
+  void store(size_t index, const Matrix& matrix) {
+    for (size_t i = 0; i < N; ++i) {
+      for (size_t j = 0; j < N; ++j) {
+        plane(i, j)[index] = matrix[i][j];
+      }
+    }
+  }
+
+  // target[k] = cofactor (row, col) of matrix k times reciprocal[k - begin].
+  // The minor's planes are picked once, so the loop over k is straight-line.
+  void inverseCofactors(size_t row, size_t col, size_t begin, size_t end,
+                        const T* reciprocal, T* __restrict target) const {
+    const T* minor[(N - 1) * (N - 1)];
+    for (size_t i = 0; i + 1 < N; ++i) {
+      for (size_t j = 0; j + 1 < N; ++j) {
+        minor[i * (N - 1) + j] =
+            plane(i < row ? i : i + 1, j < col ? j : j + 1);
+      }
+    }
+    T sign = (row + col) % 2 == 0 ? T(1) : T(-1);
+    for (size_t k = begin; k < end; ++k) {
+      FixedMatrix<N - 1, N - 1, T> matrix;
+      for (size_t i = 0; i + 1 < N; ++i) {
+        for (size_t j = 0; j + 1 < N; ++j) {
+          matrix[i][j] = minor[i * (N - 1) + j][k];
+        }
+      }
+      target[k] = sign * matrix.det() * reciprocal[k - begin];
+    }
+  }
+
+  template <class Kernel>
+  void forEachBlock(const Kernel& kernel) const {
+    size_t blocks = (size_ + kBlock - 1) / kBlock;
+    auto run = [&](size_t block) {
+      kernel(block * kBlock, std::min(size_, (block + 1) * kBlock));
+    };
+    if (blocks == 1) {
+      run(0);
+    } else if (blocks > 1) {
+      ThreadPool::instance().parallelFor(blocks, run);
+    }
+  }
+
+  T* data_;
+  size_t size_;
+  size_t stride_;
+};
+
+}  // namespace task
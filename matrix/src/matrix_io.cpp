@@ -0,0 +1,541 @@
+#include "matrix_io.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace task {
+
+namespace {
+
+const char kMagic[4] = {'T', 'M', 'A', 'T'};
+const uint32_t kVersion = 1;
+const uint32_t kByteOrder = 0x01020304;
+
+template <class T>
+DataType dataTypeOf() {
+  if constexpr (std::is_same_v<T, float>) {
+    return DataType::kFloat32;
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    return DataType::kInt64;
+  } else if constexpr (std::is_same_v<T, std::complex<double>>) {
+    return DataType::kComplex128;
+  } else {
+    static_assert(std::is_same_v<T, double>, "no binary element type");
+    return DataType::kFloat64;
+  }
+}
+
+template <class T>
+BinaryHeader makeHeader(const BasicMatrix<T>& matrix) {
+  BinaryHeader header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order = kByteOrder;
+  header.data_type = static_cast<uint32_t>(dataTypeOf<T>());
+  header.element_size = sizeof(T);
+  header.alignment = kMatrixAlignment;
+  header.rows = matrix.getRowSize();
+  header.cols = matrix.getColSize();
+  header.payload_offset = sizeof(BinaryHeader);
+  return header;
+}
+
+// Returns the payload size in bytes.
+template <class T>
+uint64_t checkHeader(const BinaryHeader& header) {
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.byte_order != kByteOrder ||
+      header.data_type != static_cast<uint32_t>(dataTypeOf<T>()) ||
+      header.element_size != sizeof(T) ||
+      header.payload_offset < sizeof(BinaryHeader) ||
+      header.payload_offset % sizeof(T) != 0) {
+    throw FileFormatException();
+  }
+  if (header.cols != 0 &&
+      header.rows > UINT64_MAX / header.cols / sizeof(T)) {
+    throw FileFormatException();
+  }
+  return header.rows * header.cols * sizeof(T);
+}
+
+// Longest number the text paths handle in their fixed buffers. Longer ones
+// are written through iostreams and read through a std::string.
+const size_t kMaxNumberLength = 512;
+
+bool isSpace(int c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+// Parses a whole token, accepting the leading '+' that iostreams accept.
+template <class T>
+bool parseNumber(const char* first, const char* last, T& value) {
+  if (first != last && *first == '+' && last - first > 1 && first[1] != '-') {
+    ++first;
+  }
+  std::from_chars_result result = std::from_chars(first, last, value);
+  return result.ec == std::errc() && result.ptr == last;
+}
+
+// Reads the next whitespace-separated token straight from the stream buffer.
+// Returns its length, 0 at the end of input.
+size_t readToken(std::streambuf* buffer, char* token) {
+  int c = buffer->sgetc();
+  while (c != EOF && isSpace(c)) {
+    c = buffer->snextc();
+  }
+  size_t length = 0;
+  while (c != EOF && !isSpace(c) && length < kMaxNumberLength) {
+    token[length++] = static_cast<char>(c);
+    c = buffer->snextc();
+  }
+  return length;
+}
+
+// to_chars matches printf("%.*g") and friends, which is what iostreams
+// produce unless one of these flags, a field width or hexfloat is in effect.
+bool useFastFormat(const std::ios_base& stream) {
+  std::ios_base::fmtflags unsupported =
+      std::ios_base::showpos | std::ios_base::showpoint |
+      std::ios_base::uppercase;
+  std::ios_base::fmtflags field = stream.flags() & std::ios_base::floatfield;
+  return stream.width() == 0 && (stream.flags() & unsupported) == 0 &&
+         field != std::ios_base::floatfield;
+}
+
+std::chars_format floatFormat(const std::ios_base& stream) {
+  std::ios_base::fmtflags field = stream.flags() & std::ios_base::floatfield;
+  if (field == std::ios_base::fixed) return std::chars_format::fixed;
+  if (field == std::ios_base::scientific) return std::chars_format::scientific;
+  return std::chars_format::general;
+}
+
+// Integers, like their iostream output, ignore format and precision.
+template <class T>
+std::to_chars_result formatNumber(char* first, char* last, T value,
+                                  std::chars_format format, int precision) {
+  if constexpr (std::is_integral_v<T>) {
+    return std::to_chars(first, last, value);
+  } else {
+    return std::to_chars(first, last, value, format, precision);
+  }
+}
+
+template <class T>
+void writeFast(std::ostream& output, const T* data, size_t size) {
+  std::chars_format format = floatFormat(output);
+  int precision = static_cast<int>(output.precision());
+  char buffer[1 << 14];
+  char* end = buffer + sizeof(buffer);
+  char* position = buffer;
+  for (size_t i = 0; i < size; ++i) {
+    if (end - position < static_cast<ptrdiff_t>(kMaxNumberLength)) {
+      output.write(buffer, position - buffer);
+      position = buffer;
+    }
+    std::to_chars_result result =
+        formatNumber(position, end - 1, data[i], format, precision);
+    if (result.ec == std::errc()) {
+      position = result.ptr;
+    } else {
+      output.write(buffer, position - buffer);
+      position = buffer;
+      output << data[i];
+    }
+    *position++ = ' ';
+  }
+  *position++ = '\n';
+  output.write(buffer, position - buffer);
+}
+
+template <class T>
+void readFast(std::istream& input, T* data, size_t size) {
+  std::streambuf* buffer = input.rdbuf();
+  char token[kMaxNumberLength];
+  for (size_t i = 0; i < size; ++i) {
+    size_t length = readToken(buffer, token);
+    if (length == 0) {
+      input.setstate(std::ios_base::eofbit | std::ios_base::failbit);
+      return;
+    }
+    bool parsed;
+    if (length < kMaxNumberLength) {
+      parsed = parseNumber(token, token + length, data[i]);
+    } else {
+      std::string long_token(token, length);
+      for (int c = buffer->sgetc(); c != EOF && !isSpace(c);
+           c = buffer->snextc()) {
+        long_token.push_back(static_cast<char>(c));
+      }
+      parsed = parseNumber(long_token.data(),
+                           long_token.data() + long_token.size(), data[i]);
+    }
+    if (!parsed) {
+      input.setstate(std::ios_base::failbit);
+      return;
+    }
+  }
+}
+
+// A stream that ends early holds a truncated file, as a mapping that is too
+// short does; any other failure is an I/O error.
+void checkRead(const std::istream& input) {
+  if (input.eof()) {
+    throw FileFormatException();
+  }
+  if (!input) {
+    throw IoException();
+  }
+}
+
+}  // namespace
+
+// Complex elements have no to_chars/from_chars form and always go through
+// the iostream operators, as "(re,im)".
+template <class T>
+std::ostream& operator<<(std::ostream& output, const BasicMatrix<T>& matrix) {
+  OperationScope scope(Operation::kWrite);
+  size_t size = matrix.getRowSize() * matrix.getColSize();
+  const T* data = matrix[0];
+  if constexpr (std::is_arithmetic_v<T>) {
+    if (useFastFormat(output)) {
+      writeFast(output, data, size);
+      return output;
+    }
+  }
+  for (size_t i = 0; i < size; ++i) {
+    output << data[i] << " ";
+  }
+  output << "\n";
+  return output;
+}
+
+template <class T>
+std::istream& operator>>(std::istream& input, BasicMatrix<T>& matrix) {
+  OperationScope scope(Operation::kRead);
+  size_t row;
+  size_t col;
+  if (!(input >> row >> col)) {
+    return input;
+  }
+  matrix = BasicMatrix<T>(row, col);
+  if constexpr (std::is_arithmetic_v<T>) {
+    readFast(input, matrix[0], row * col);
+  } else {
+    T* data = matrix[0];
+    for (size_t i = 0; i < row * col; ++i) {
+      if (!(input >> data[i])) break;
+    }
+  }
+  return input;
+}
+
+template <class T>
+void writeBinary(std::ostream& output, const BasicMatrix<T>& matrix) {
+  BinaryHeader header = makeHeader(matrix);
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char*>(matrix[0]),
+               matrix.getRowSize() * matrix.getColSize() * sizeof(T));
+  if (!output) {
+    throw IoException();
+  }
+}
+
+template <class T>
+BasicMatrix<T> readBinary(std::istream& input) {
+  BinaryHeader header;
+  input.read(reinterpret_cast<char*>(&header), sizeof(header));
+  checkRead(input);
+  uint64_t bytes = checkHeader<T>(header);
+  input.ignore(header.payload_offset - sizeof(header));
+  BasicMatrix<T> matrix(header.rows, header.cols);
+  input.read(reinterpret_cast<char*>(matrix[0]), bytes);
+  checkRead(input);
+  return matrix;
+}
+
+template <class T>
+void saveBinary(const std::string& path, const BasicMatrix<T>& matrix) {
+  std::ofstream output(path, std::ios::binary);
+  if (!output) {
+    throw IoException();
+  }
+  writeBinary(output, matrix);
+}
+
+template <class T>
+BasicMatrix<T> loadBinary(const std::string& path) {
+  std::ifstream input(path, std::ios::binary);
+  if (!input) {
+    throw IoException();
+  }
+  return readBinary<T>(input);
+}
+
+MappedMatrix::MappedMatrix(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw IoException();
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw IoException();
+  }
+  mapping_size_ = info.st_size;
+  if (mapping_size_ < sizeof(BinaryHeader)) {
+    close(fd);
+    throw FileFormatException();
+  }
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping_ == MAP_FAILED) {
+    throw IoException();
+  }
+  BinaryHeader header;
+  std::memcpy(&header, mapping_, sizeof(header));
+  uint64_t bytes;
+  try {
+    bytes = checkHeader<double>(header);
+  } catch (...) {
+    munmap(mapping_, mapping_size_);
+    throw;
+  }
+  if (header.payload_offset > mapping_size_ ||
+      bytes > mapping_size_ - header.payload_offset) {
+    munmap(mapping_, mapping_size_);
+    throw FileFormatException();
+  }
+  data_ = reinterpret_cast<const double*>(static_cast<const char*>(mapping_) +
+                                          header.payload_offset);
+  row_size_ = header.rows;
+  col_size_ = header.cols;
+}
+
+MappedMatrix::MappedMatrix(MappedMatrix&& other) noexcept
+    : mapping_(other.mapping_),
+      mapping_size_(other.mapping_size_),
+      data_(other.data_),
+      row_size_(other.row_size_),
+      col_size_(other.col_size_) {
+  other.mapping_ = nullptr;
+  other.mapping_size_ = 0;
+  other.data_ = nullptr;
+  other.row_size_ = 0;
+  other.col_size_ = 0;
+}
+
+MappedMatrix::~MappedMatrix() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+const double& MappedMatrix::get(size_t row, size_t col) const {
+  if (row >= row_size_ || col >= col_size_) {
+    throw OutOfBoundsException();
+  }
+  return data_[row * col_size_ + col];
+}
+
+ConstMatrixView MappedMatrix::view() const {
+  return ConstMatrixView(data_, row_size_, col_size_, col_size_, 1);
+}
+
+MatrixReader::MatrixReader(std::istream& input, size_t buffer_size)
+    : input_(input),
+      buffer_(std::max(buffer_size, 2 * kMaxNumberLength)),
+      begin_(0),
+      end_(0),
+      exhausted_(false) {}
+
+void MatrixReader::refill() {
+  std::copy(buffer_.begin() + begin_, buffer_.begin() + end_,
+            buffer_.begin());
+  end_ -= begin_;
+  begin_ = 0;
+  std::streamsize capacity =
+      static_cast<std::streamsize>(buffer_.size() - end_);
+  std::streamsize count =
+      input_.rdbuf()->sgetn(buffer_.data() + end_, capacity);
+  if (count <= 0) {
+    exhausted_ = true;
+  } else {
+    end_ += static_cast<size_t>(count);
+  }
+}
+
+bool MatrixReader::nextToken(const char*& first, const char*& last) {
+  while (true) {
+    while (begin_ < end_ && isSpace(buffer_[begin_])) {
+      ++begin_;
+    }
+    if (begin_ < end_ || exhausted_) break;
+    refill();
+  }
+  if (begin_ == end_) return false;
+  if (end_ - begin_ < kMaxNumberLength && !exhausted_) {
+    refill();
+  }
+  size_t position = begin_;
+  size_t limit = std::min(end_, begin_ + kMaxNumberLength);
+  while (position < limit && !isSpace(buffer_[position])) {
+    ++position;
+  }
+  if (position == limit && limit != end_) {
+    return nextLongToken(first, last);
+  }
+  first = buffer_.data() + begin_;
+  last = buffer_.data() + position;
+  begin_ = position;
+  return true;
+}
+
+// A token that does not fit the kMaxNumberLength window nextToken keeps
+// ahead is collected in long_token_, across as many refills as it takes.
+bool MatrixReader::nextLongToken(const char*& first, const char*& last) {
+  long_token_.clear();
+  while (true) {
+    size_t position = begin_;
+    while (position < end_ && !isSpace(buffer_[position])) {
+      ++position;
+    }
+    long_token_.append(buffer_.data() + begin_, position - begin_);
+    begin_ = position;
+    if (position < end_ || exhausted_) break;
+    refill();
+  }
+  first = long_token_.data();
+  last = first + long_token_.size();
+  return true;
+}
+
+bool MatrixReader::read(double& value) {
+  const char* first;
+  const char* last;
+  if (!nextToken(first, last)) return false;
+  if (!parseNumber(first, last, value)) {
+    throw FileFormatException();
+  }
+  return true;
+}
+
+template <class T>
+bool MatrixReader::read(BasicMatrix<T>& matrix) {
+  static_assert(std::is_arithmetic_v<T>, "text elements must be real");
+  const char* first;
+  const char* last;
+  size_t rows;
+  size_t cols;
+  if (!nextToken(first, last)) return false;
+  if (!parseNumber(first, last, rows) || !nextToken(first, last) ||
+      !parseNumber(first, last, cols)) {
+    throw FileFormatException();
+  }
+  matrix = BasicMatrix<T>(rows, cols);
+  T* data = matrix[0];
+  for (size_t i = 0; i < rows * cols; ++i) {
+    if (!nextToken(first, last) || !parseNumber(first, last, data[i])) {
+      throw FileFormatException();
+    }
+  }
+  return true;
+}
+
+MatrixWriter::MatrixWriter(std::ostream& output, int precision,
+                           size_t buffer_size)
+    : output_(output),
+      precision_(std::min(precision, 17)),
+      buffer_(std::max(buffer_size, 2 * kMaxNumberLength)),
+      size_(0) {}
+
+MatrixWriter::~MatrixWriter() { flush(); }
+
+void MatrixWriter::flush() {
+  output_.write(buffer_.data(), static_cast<std::streamsize>(size_));
+  size_ = 0;
+}
+
+void MatrixWriter::reserve(size_t size) {
+  if (buffer_.size() - size_ < size) {
+    flush();
+  }
+}
+
+template <class T>
+void MatrixWriter::append(T value) {
+  reserve(kMaxNumberLength + 1);
+  char* first = buffer_.data() + size_;
+  int precision = std::min(precision_, std::numeric_limits<T>::max_digits10);
+  std::to_chars_result result =
+      formatNumber(first, first + kMaxNumberLength, value,
+                   std::chars_format::general, precision);
+  size_ = result.ptr - buffer_.data();
+}
+
+template <class T>
+void MatrixWriter::write(const BasicMatrix<T>& matrix) {
+  static_assert(std::is_arithmetic_v<T>, "text elements must be real");
+  append(matrix.getRowSize());
+  buffer_[size_++] = ' ';
+  append(matrix.getColSize());
+  buffer_[size_++] = '\n';
+  for (size_t i = 0; i < matrix.getRowSize(); ++i) {
+    const T* row = matrix[i];
+    for (size_t j = 0; j < matrix.getColSize(); ++j) {
+      append(row[j]);
+      buffer_[size_++] = j + 1 < matrix.getColSize() ? ' ' : '\n';
+    }
+  }
+}
+
+void MatrixWriter::write(double value) {
+  append(value);
+  buffer_[size_++] = '\n';
+}
+
+template std::ostream& operator<<(std::ostream&, const BasicMatrix<float>&);
+template std::ostream& operator<<(std::ostream&, const BasicMatrix<double>&);
+template std::ostream& operator<<(std::ostream&, const BasicMatrix<int64_t>&);
+template std::ostream& operator<<(std::ostream&,
+                                  const BasicMatrix<std::complex<double>>&);
+template std::istream& operator>>(std::istream&, BasicMatrix<float>&);
+template std::istream& operator>>(std::istream&, BasicMatrix<double>&);
+template std::istream& operator>>(std::istream&, BasicMatrix<int64_t>&);
+template std::istream& operator>>(std::istream&,
+                                  BasicMatrix<std::complex<double>>&);
+
+template void writeBinary(std::ostream&, const BasicMatrix<float>&);
+template void writeBinary(std::ostream&, const BasicMatrix<double>&);
+template void writeBinary(std::ostream&, const BasicMatrix<int64_t>&);
+template void writeBinary(std::ostream&,
+                          const BasicMatrix<std::complex<double>>&);
+template BasicMatrix<float> readBinary(std::istream&);
+template BasicMatrix<double> readBinary(std::istream&);
+template BasicMatrix<int64_t> readBinary(std::istream&);
+template BasicMatrix<std::complex<double>> readBinary(std::istream&);
+template void saveBinary(const std::string&, const BasicMatrix<float>&);
+template void saveBinary(const std::string&, const BasicMatrix<double>&);
+template void saveBinary(const std::string&, const BasicMatrix<int64_t>&);
+template void saveBinary(const std::string&,
+                         const BasicMatrix<std::complex<double>>&);
+template BasicMatrix<float> loadBinary(const std::string&);
+template BasicMatrix<double> loadBinary(const std::string&);
+template BasicMatrix<int64_t> loadBinary(const std::string&);
+template BasicMatrix<std::complex<double>> loadBinary(const std::string&);
+
+template bool MatrixReader::read(BasicMatrix<float>&);
+template bool MatrixReader::read(BasicMatrix<double>&);
+template bool MatrixReader::read(BasicMatrix<int64_t>&);
+template void MatrixWriter::write(const BasicMatrix<float>&);
+template void MatrixWriter::write(const BasicMatrix<double>&);
+template void MatrixWriter::write(const BasicMatrix<int64_t>&);
+
+}  // namespace task
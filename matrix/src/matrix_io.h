@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+
+namespace task {
+
+class FileFormatException : public std::exception {};
+class IoException : public std::exception {};
+
+enum class DataType : uint32_t {
+  kFloat64 = 1,
+  kFloat32 = 2,
+  kInt64 = 3,
+  kComplex128 = 4
+};
+
+// On-disk layout: this 64-byte header followed, at payload_offset, by the
+// rows * cols elements in row-major order and native byte order.
+struct BinaryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t data_type;
+  uint32_t element_size;
+  uint32_t alignment;
+  uint64_t rows;
+  uint64_t cols;
+  uint64_t payload_offset;
+  char reserved[16];
+};
+
+static_assert(sizeof(BinaryHeader) == kMatrixAlignment,
+              "the payload must stay aligned after the header");
+
+// Reading checks that the stored element type is T. Malformed or truncated
+// input throws FileFormatException, a failing stream IoException.
+template <class T>
+void writeBinary(std::ostream& output, const BasicMatrix<T>& matrix);
+template <class T = double>
+BasicMatrix<T> readBinary(std::istream& input);
+template <class T>
+void saveBinary(const std::string& path, const BasicMatrix<T>& matrix);
+template <class T = double>
+BasicMatrix<T> loadBinary(const std::string& path);
+
+// Read-only matrix backed by a memory-mapped binary file. Opening only maps
+// the file; pages are read from disk the first time they are touched.
+class MappedMatrix : public MatrixExpr<MappedMatrix> {
+ public:
+  using Scalar = double;
+
+  explicit MappedMatrix(const std::string& path);
+  MappedMatrix(MappedMatrix&& other) noexcept;
+  MappedMatrix(const MappedMatrix&) = delete;
+  MappedMatrix& operator=(const MappedMatrix&) = delete;
+  ~MappedMatrix();
+
+  size_t getRowSize() const { return row_size_; }
+  size_t getColSize() const { return col_size_; }
+  double coeff(size_t row, size_t col) const {
+    return data_[row * col_size_ + col];
+  }
+  const double& get(size_t row, size_t col) const;
+  const double* operator[](size_t row) const { return data_ + row * col_size_; }
+
+  ConstMatrixView view() const;
+  operator ConstMatrixView() const { return view(); }
+
+ private:
+  void* mapping_;
+  size_t mapping_size_;
+  const double* data_;
+  size_t row_size_;
+  size_t col_size_;
+};
+
+// A mapping never shares memory with a Matrix buffer.
+inline bool readsFrom(const MappedMatrix&, const double*, const double*) {
+  return false;
+}
+
+template <>
+struct ExprStorage<MappedMatrix> {
+  using type = const MappedMatrix&;
+};
+
+inline ConstMatrixView evaluated(const MappedMatrix& a) { return a.view(); }
+
+// Reads a sequence of text matrices ("rows cols" followed by the values) and
+// plain numbers from a stream through a large block buffer. The reader takes
+// over the stream: it consumes input ahead of what it has returned. Real
+// element types only: float, double and int64_t.
+class MatrixReader {
+ public:
+  explicit MatrixReader(std::istream& input, size_t buffer_size = 1 << 20);
+
+  // Return false at the end of input; malformed input throws
+  // FileFormatException.
+  template <class T>
+  bool read(BasicMatrix<T>& matrix);
+  bool read(double& value);
+
+ private:
+  bool nextToken(const char*& first, const char*& last);
+  bool nextLongToken(const char*& first, const char*& last);
+  void refill();
+
+  std::istream& input_;
+  std::vector<char> buffer_;
+  size_t begin_;
+  size_t end_;
+  bool exhausted_;
+  std::string long_token_;
+};
+
+// Writes matrices in the layout MatrixReader and operator>> accept, one row
+// per line, buffering output in large blocks. The default precision of 17
+// significant digits round-trips every double; more is never needed, and
+// floats are written with at most the 9 digits they need.
+class MatrixWriter {
+ public:
+  explicit MatrixWriter(std::ostream& output, int precision = 17,
+                        size_t buffer_size = 1 << 20);
+  MatrixWriter(const MatrixWriter&) = delete;
+  MatrixWriter& operator=(const MatrixWriter&) = delete;
+  ~MatrixWriter();
+
+  template <class T>
+  void write(const BasicMatrix<T>& matrix);
+  void write(double value);
+  void flush();
+
+ private:
+  void reserve(size_t size);
+  template <class T>
+  void append(T value);
+
+  std::ostream& output_;
+  int precision_;
+  std::vector<char> buffer_;
+  size_t size_;
+};
+
+}  // namespace task
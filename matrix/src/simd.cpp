@@ -0,0 +1,715 @@
+#include "simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TASK_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace task {
+namespace simd {
+
+namespace {
+
+template <class T>
+struct ElementKernels {
+  void (*add)(size_t, const T*, const T*, T*);
+  void (*subtract)(size_t, const T*, const T*, T*);
+  void (*scale)(size_t, T, const T*, T*);
+  void (*negate)(size_t, const T*, T*);
+  void (*axpy)(size_t, T, const T*, T*);
+  T (*strided_sum)(size_t, const T*, size_t);
+  bool (*all_close)(size_t, const T*, const T*, double);
+};
+
+struct Kernels {
+  ElementKernels<double> float64;
+  ElementKernels<float> float32;
+};
+
+namespace scalar {
+
+const Kernels kKernels = {
+    {portable::add<double>, portable::subtract<double>,
+     portable::scale<double>, portable::negate<double>, portable::axpy<double>,
+     portable::stridedSum<double>, portable::allClose<double>},
+    {portable::add<float>, portable::subtract<float>, portable::scale<float>,
+     portable::negate<float>, portable::axpy<float>,
+     portable::stridedSum<float>, portable::allClose<float>}};
+
+}  // namespace scalar
+
+#ifdef TASK_SIMD_X86
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+
+namespace sse2 {
+
+void add(size_t n, const double* a, const double* b, double* out) {
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(out + i,
+                  _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+  }
+  portable::add(n - i, a + i, b + i, out + i);
+}
+
+void subtract(size_t n, const double* a, const double* b, double* out) {
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(out + i,
+                  _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+  }
+  portable::subtract(n - i, a + i, b + i, out + i);
+}
+
+void scale(size_t n, double alpha, const double* x, double* out) {
+  __m128d factor = _mm_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(out + i, _mm_mul_pd(factor, _mm_loadu_pd(x + i)));
+  }
+  portable::scale(n - i, alpha, x + i, out + i);
+}
+
+void negate(size_t n, const double* x, double* out) {
+  __m128d sign = _mm_set1_pd(-0.0);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(out + i, _mm_xor_pd(sign, _mm_loadu_pd(x + i)));
+  }
+  portable::negate(n - i, x + i, out + i);
+}
+
+void axpy(size_t n, double alpha, const double* x, double* y) {
+  __m128d factor = _mm_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128d product = _mm_mul_pd(factor, _mm_loadu_pd(x + i));
+    _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), product));
+  }
+  portable::axpy(n - i, alpha, x + i, y + i);
+}
+
+double stridedSum(size_t n, const double* x, size_t stride) {
+  __m128d sum = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    sum = _mm_add_pd(sum, _mm_set_pd(x[(i + 1) * stride], x[i * stride]));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, sum);
+  return lanes[0] + lanes[1] +
+         portable::stridedSum(n - i, x + i * stride, stride);
+}
+
+bool allClose(size_t n, const double* a, const double* b, double eps) {
+  __m128d sign = _mm_set1_pd(-0.0);
+  __m128d limit = _mm_set1_pd(eps);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128d diff = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+    __m128d over = _mm_cmpgt_pd(_mm_andnot_pd(sign, diff), limit);
+    if (_mm_movemask_pd(over) != 0) return false;
+  }
+  return portable::allClose(n - i, a + i, b + i, eps);
+}
+
+void add(size_t n, const float* a, const float* b, float* out) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(out + i,
+                  _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+  portable::add(n - i, a + i, b + i, out + i);
+}
+
+void subtract(size_t n, const float* a, const float* b, float* out) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(out + i,
+                  _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+  portable::subtract(n - i, a + i, b + i, out + i);
+}
+
+void scale(size_t n, float alpha, const float* x, float* out) {
+  __m128 factor = _mm_set1_ps(alpha);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(out + i, _mm_mul_ps(factor, _mm_loadu_ps(x + i)));
+  }
+  portable::scale(n - i, alpha, x + i, out + i);
+}
+
+void negate(size_t n, const float* x, float* out) {
+  __m128 sign = _mm_set1_ps(-0.0f);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(out + i, _mm_xor_ps(sign, _mm_loadu_ps(x + i)));
+  }
+  portable::negate(n - i, x + i, out + i);
+}
+
+void axpy(size_t n, float alpha, const float* x, float* y) {
+  __m128 factor = _mm_set1_ps(alpha);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 product = _mm_mul_ps(factor, _mm_loadu_ps(x + i));
+    _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), product));
+  }
+  portable::axpy(n - i, alpha, x + i, y + i);
+}
+
+float stridedSum(size_t n, const float* x, size_t stride) {
+  __m128 sum = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    sum = _mm_add_ps(sum, _mm_set_ps(x[(i + 3) * stride], x[(i + 2) * stride],
+                                     x[(i + 1) * stride], x[i * stride]));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, sum);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+         portable::stridedSum(n - i, x + i * stride, stride);
+}
+
+bool allClose(size_t n, const float* a, const float* b, double eps) {
+  __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 limit = _mm_set1_ps(static_cast<float>(eps));
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 diff = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    __m128 over = _mm_cmpgt_ps(_mm_andnot_ps(sign, diff), limit);
+    if (_mm_movemask_ps(over) != 0) return false;
+  }
+  return portable::allClose(n - i, a + i, b + i, eps);
+}
+
+const Kernels kKernels = {
+    {add, subtract, scale, negate, axpy, stridedSum, allClose},
+    {add, subtract, scale, negate, axpy, stridedSum, allClose}};
+
+}  // namespace sse2
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+namespace avx2 {
+
+void add(size_t n, const double* a, const double* b, double* out) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i),
+                                            _mm256_loadu_pd(b + i)));
+  }
+  portable::add(n - i, a + i, b + i, out + i);
+}
+
+void subtract(size_t n, const double* a, const double* b, double* out) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(a + i),
+                                            _mm256_loadu_pd(b + i)));
+  }
+  portable::subtract(n - i, a + i, b + i, out + i);
+}
+
+void scale(size_t n, double alpha, const double* x, double* out) {
+  __m256d factor = _mm256_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(factor, _mm256_loadu_pd(x + i)));
+  }
+  portable::scale(n - i, alpha, x + i, out + i);
+}
+
+void negate(size_t n, const double* x, double* out) {
+  __m256d sign = _mm256_set1_pd(-0.0);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_xor_pd(sign, _mm256_loadu_pd(x + i)));
+  }
+  portable::negate(n - i, x + i, out + i);
+}
+
+void axpy(size_t n, double alpha, const double* x, double* y) {
+  __m256d factor = _mm256_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(y + i, _mm256_fmadd_pd(factor, _mm256_loadu_pd(x + i),
+                                            _mm256_loadu_pd(y + i)));
+  }
+  portable::axpy(n - i, alpha, x + i, y + i);
+}
+
+double stridedSum(size_t n, const double* x, size_t stride) {
+  long long step = static_cast<long long>(stride);
+  __m256i index = _mm256_set_epi64x(3 * step, 2 * step, step, 0);
+  __m256d sum = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    sum = _mm256_add_pd(sum, _mm256_i64gather_pd(x + i * stride, index, 8));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, sum);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+         portable::stridedSum(n - i, x + i * stride, stride);
+}
+
+bool allClose(size_t n, const double* a, const double* b, double eps) {
+  __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d limit = _mm256_set1_pd(eps);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d diff =
+        _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+    __m256d over =
+        _mm256_cmp_pd(_mm256_andnot_pd(sign, diff), limit, _CMP_GT_OQ);
+    if (_mm256_movemask_pd(over) != 0) return false;
+  }
+  return portable::allClose(n - i, a + i, b + i, eps);
+}
+
+void add(size_t n, const float* a, const float* b, float* out) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i),
+                                            _mm256_loadu_ps(b + i)));
+  }
+  portable::add(n - i, a + i, b + i, out + i);
+}
+
+void subtract(size_t n, const float* a, const float* b, float* out) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_loadu_ps(a + i),
+                                            _mm256_loadu_ps(b + i)));
+  }
+  portable::subtract(n - i, a + i, b + i, out + i);
+}
+
+void scale(size_t n, float alpha, const float* x, float* out) {
+  __m256 factor = _mm256_set1_ps(alpha);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(factor, _mm256_loadu_ps(x + i)));
+  }
+  portable::scale(n - i, alpha, x + i, out + i);
+}
+
+void negate(size_t n, const float* x, float* out) {
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_xor_ps(sign, _mm256_loadu_ps(x + i)));
+  }
+  portable::negate(n - i, x + i, out + i);
+}
+
+void axpy(size_t n, float alpha, const float* x, float* y) {
+  __m256 factor = _mm256_set1_ps(alpha);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(y + i, _mm256_fmadd_ps(factor, _mm256_loadu_ps(x + i),
+                                            _mm256_loadu_ps(y + i)));
+  }
+  portable::axpy(n - i, alpha, x + i, y + i);
+}
+
+// Gathers four lanes at a time: 64-bit indices keep large strides in range.
+float stridedSum(size_t n, const float* x, size_t stride) {
+  long long step = static_cast<long long>(stride);
+  __m256i index = _mm256_set_epi64x(3 * step, 2 * step, step, 0);
+  __m128 sum = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    sum = _mm_add_ps(sum, _mm256_i64gather_ps(x + i * stride, index, 4));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, sum);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+         portable::stridedSum(n - i, x + i * stride, stride);
+}
+
+bool allClose(size_t n, const float* a, const float* b, double eps) {
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 limit = _mm256_set1_ps(static_cast<float>(eps));
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 diff =
+        _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    __m256 over =
+        _mm256_cmp_ps(_mm256_andnot_ps(sign, diff), limit, _CMP_GT_OQ);
+    if (_mm256_movemask_ps(over) != 0) return false;
+  }
+  return portable::allClose(n - i, a + i, b + i, eps);
+}
+
+const Kernels kKernels = {
+    {add, subtract, scale, negate, axpy, stridedSum, allClose},
+    {add, subtract, scale, negate, axpy, stridedSum, allClose}};
+
+}  // namespace avx2
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+namespace avx512 {
+
+__mmask8 tailMask(size_t count) {
+  return static_cast<__mmask8>((1u << count) - 1);
+}
+
+void add(size_t n, const double* a, const double* b, double* out) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_loadu_pd(a + i),
+                                            _mm512_loadu_pd(b + i)));
+  }
+  __mmask8 mask = tailMask(n - i);
+  _mm512_mask_storeu_pd(out + i, mask,
+                        _mm512_add_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                                      _mm512_maskz_loadu_pd(mask, b + i)));
+}
+
+void subtract(size_t n, const double* a, const double* b, double* out) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(out + i, _mm512_sub_pd(_mm512_loadu_pd(a + i),
+                                            _mm512_loadu_pd(b + i)));
+  }
+  __mmask8 mask = tailMask(n - i);
+  _mm512_mask_storeu_pd(out + i, mask,
+                        _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                                      _mm512_maskz_loadu_pd(mask, b + i)));
+}
+
+void scale(size_t n, double alpha, const double* x, double* out) {
+  __m512d factor = _mm512_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(out + i, _mm512_mul_pd(factor, _mm512_loadu_pd(x + i)));
+  }
+  __mmask8 mask = tailMask(n - i);
+  _mm512_mask_storeu_pd(
+      out + i, mask, _mm512_mul_pd(factor, _mm512_maskz_loadu_pd(mask, x + i)));
+}
+
+// AVX-512F has no floating-point xor, so the sign bit is flipped in the
+// integer domain, as the other levels do with xor_pd.
+__m512d flipSign(__m512d x) {
+  return _mm512_castsi512_pd(_mm512_xor_si512(
+      _mm512_castpd_si512(x), _mm512_set1_epi64(INT64_MIN)));
+}
+
+void negate(size_t n, const double* x, double* out) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(out + i, flipSign(_mm512_loadu_pd(x + i)));
+  }
+  __mmask8 mask = tailMask(n - i);
+  _mm512_mask_storeu_pd(out + i, mask,
+                        flipSign(_mm512_maskz_loadu_pd(mask, x + i)));
+}
+
+void axpy(size_t n, double alpha, const double* x, double* y) {
+  __m512d factor = _mm512_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(y + i, _mm512_fmadd_pd(factor, _mm512_loadu_pd(x + i),
+                                            _mm512_loadu_pd(y + i)));
+  }
+  __mmask8 mask = tailMask(n - i);
+  _mm512_mask_storeu_pd(
+      y + i, mask,
+      _mm512_fmadd_pd(factor, _mm512_maskz_loadu_pd(mask, x + i),
+                      _mm512_maskz_loadu_pd(mask, y + i)));
+}
+
+double stridedSum(size_t n, const double* x, size_t stride) {
+  long long step = static_cast<long long>(stride);
+  __m512i index = _mm512_set_epi64(7 * step, 6 * step, 5 * step, 4 * step,
+                                   3 * step, 2 * step, step, 0);
+  __m512d zero = _mm512_setzero_pd();
+  __m512d sum = zero;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    sum = _mm512_add_pd(
+        sum, _mm512_mask_i64gather_pd(zero, 0xff, index, x + i * stride, 8));
+  }
+  double lanes[8];
+  _mm512_storeu_pd(lanes, sum);
+  double result = 0.0;
+  for (double lane : lanes) result += lane;
+  return result + portable::stridedSum(n - i, x + i * stride, stride);
+}
+
+bool allClose(size_t n, const double* a, const double* b, double eps) {
+  __m512d limit = _mm512_set1_pd(eps);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512d diff =
+        _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+    if (_mm512_cmp_pd_mask(_mm512_abs_pd(diff), limit, _CMP_GT_OQ) != 0) {
+      return false;
+    }
+  }
+  __mmask8 mask = tailMask(n - i);
+  __m512d diff = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                               _mm512_maskz_loadu_pd(mask, b + i));
+  return _mm512_mask_cmp_pd_mask(mask, _mm512_abs_pd(diff), limit,
+                                 _CMP_GT_OQ) == 0;
+}
+
+__mmask16 tailMask16(size_t count) {
+  return static_cast<__mmask16>((1u << count) - 1);
+}
+
+void add(size_t n, const float* a, const float* b, float* out) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_loadu_ps(a + i),
+                                            _mm512_loadu_ps(b + i)));
+  }
+  __mmask16 mask = tailMask16(n - i);
+  _mm512_mask_storeu_ps(out + i, mask,
+                        _mm512_add_ps(_mm512_maskz_loadu_ps(mask, a + i),
+                                      _mm512_maskz_loadu_ps(mask, b + i)));
+}
+
+void subtract(size_t n, const float* a, const float* b, float* out) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(out + i, _mm512_sub_ps(_mm512_loadu_ps(a + i),
+                                            _mm512_loadu_ps(b + i)));
+  }
+  __mmask16 mask = tailMask16(n - i);
+  _mm512_mask_storeu_ps(out + i, mask,
+                        _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i),
+                                      _mm512_maskz_loadu_ps(mask, b + i)));
+}
+
+void scale(size_t n, float alpha, const float* x, float* out) {
+  __m512 factor = _mm512_set1_ps(alpha);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(out + i, _mm512_mul_ps(factor, _mm512_loadu_ps(x + i)));
+  }
+  __mmask16 mask = tailMask16(n - i);
+  _mm512_mask_storeu_ps(
+      out + i, mask, _mm512_mul_ps(factor, _mm512_maskz_loadu_ps(mask, x + i)));
+}
+
+__m512 flipSign(__m512 x) {
+  return _mm512_castsi512_ps(_mm512_xor_si512(
+      _mm512_castps_si512(x), _mm512_set1_epi32(INT32_MIN)));
+}
+
+void negate(size_t n, const float* x, float* out) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(out + i, flipSign(_mm512_loadu_ps(x + i)));
+  }
+  __mmask16 mask = tailMask16(n - i);
+  _mm512_mask_storeu_ps(out + i, mask,
+                        flipSign(_mm512_maskz_loadu_ps(mask, x + i)));
+}
+
+void axpy(size_t n, float alpha, const float* x, float* y) {
+  __m512 factor = _mm512_set1_ps(alpha);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(y + i, _mm512_fmadd_ps(factor, _mm512_loadu_ps(x + i),
+                                            _mm512_loadu_ps(y + i)));
+  }
+  __mmask16 mask = tailMask16(n - i);
+  _mm512_mask_storeu_ps(
+      y + i, mask,
+      _mm512_fmadd_ps(factor, _mm512_maskz_loadu_ps(mask, x + i),
+                      _mm512_maskz_loadu_ps(mask, y + i)));
+}
+
+// Gathers eight lanes at a time: 64-bit indices keep large strides in range.
+float stridedSum(size_t n, const float* x, size_t stride) {
+  long long step = static_cast<long long>(stride);
+  __m512i index = _mm512_set_epi64(7 * step, 6 * step, 5 * step, 4 * step,
+                                   3 * step, 2 * step, step, 0);
+  __m256 zero = _mm256_setzero_ps();
+  __m256 sum = zero;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    sum = _mm256_add_ps(
+        sum, _mm512_mask_i64gather_ps(zero, 0xff, index, x + i * stride, 4));
+  }
+  float lanes[8];
+  _mm256_storeu_ps(lanes, sum);
+  float result = 0.0f;
+  for (float lane : lanes) result += lane;
+  return result + portable::stridedSum(n - i, x + i * stride, stride);
+}
+
+bool allClose(size_t n, const float* a, const float* b, double eps) {
+  __m512 limit = _mm512_set1_ps(static_cast<float>(eps));
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 diff =
+        _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    if (_mm512_cmp_ps_mask(_mm512_abs_ps(diff), limit, _CMP_GT_OQ) != 0) {
+      return false;
+    }
+  }
+  __mmask16 mask = tailMask16(n - i);
+  __m512 diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i),
+                              _mm512_maskz_loadu_ps(mask, b + i));
+  return _mm512_mask_cmp_ps_mask(mask, _mm512_abs_ps(diff), limit,
+                                 _CMP_GT_OQ) == 0;
+}
+
+const Kernels kKernels = {
+    {add, subtract, scale, negate, axpy, stridedSum, allClose},
+    {add, subtract, scale, negate, axpy, stridedSum, allClose}};
+
+}  // namespace avx512
+
+#pragma GCC pop_options
+
+#endif  // TASK_SIMD_X86
+
+Level detectLevel() {
+#ifdef TASK_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return Level::kAvx512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return Level::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) return Level::kSse2;
+#endif
+  return Level::kScalar;
+}
+
+const Kernels& kernelsFor(Level level) {
+  switch (level) {
+#ifdef TASK_SIMD_X86
+    case Level::kAvx512:
+      return avx512::kKernels;
+    case Level::kAvx2:
+      return avx2::kKernels;
+    case Level::kSse2:
+      return sse2::kKernels;
+#endif
+    default:
+      return scalar::kKernels;
+  }
+}
+
+// Atomic so that setLevel() may race with kernel calls on other threads.
+// The tables are constants, so relaxed loads see them fully built.
+struct Dispatch {
+  Dispatch()
+      : level(getSupportedLevel()), kernels(&kernelsFor(getSupportedLevel())) {}
+
+  std::atomic<Level> level;
+  std::atomic<const Kernels*> kernels;
+};
+
+Dispatch& dispatch() {
+  static Dispatch instance;
+  return instance;
+}
+
+template <class T>
+const ElementKernels<T>& kernels();
+
+template <>
+const ElementKernels<double>& kernels() {
+  return dispatch().kernels.load(std::memory_order_relaxed)->float64;
+}
+
+template <>
+const ElementKernels<float>& kernels() {
+  return dispatch().kernels.load(std::memory_order_relaxed)->float32;
+}
+
+}  // namespace
+
+Level getSupportedLevel() {
+  static const Level supported = detectLevel();
+  return supported;
+}
+
+Level getLevel() { return dispatch().level.load(std::memory_order_relaxed); }
+
+void setLevel(Level level) {
+  level = std::min(level, getSupportedLevel());
+  dispatch().kernels.store(&kernelsFor(level), std::memory_order_relaxed);
+  dispatch().level.store(level, std::memory_order_relaxed);
+}
+
+void add(size_t n, const double* a, const double* b, double* out) {
+  kernels<double>().add(n, a, b, out);
+}
+
+void subtract(size_t n, const double* a, const double* b, double* out) {
+  kernels<double>().subtract(n, a, b, out);
+}
+
+void scale(size_t n, double alpha, const double* x, double* out) {
+  kernels<double>().scale(n, alpha, x, out);
+}
+
+void negate(size_t n, const double* x, double* out) {
+  kernels<double>().negate(n, x, out);
+}
+
+void axpy(size_t n, double alpha, const double* x, double* y) {
+  kernels<double>().axpy(n, alpha, x, y);
+}
+
+double stridedSum(size_t n, const double* x, size_t stride) {
+  return kernels<double>().strided_sum(n, x, stride);
+}
+
+bool allClose(size_t n, const double* a, const double* b, double eps) {
+  return kernels<double>().all_close(n, a, b, eps);
+}
+
+void add(size_t n, const float* a, const float* b, float* out) {
+  kernels<float>().add(n, a, b, out);
+}
+
+void subtract(size_t n, const float* a, const float* b, float* out) {
+  kernels<float>().subtract(n, a, b, out);
+}
+
+void scale(size_t n, float alpha, const float* x, float* out) {
+  kernels<float>().scale(n, alpha, x, out);
+}
+
+void negate(size_t n, const float* x, float* out) {
+  kernels<float>().negate(n, x, out);
+}
+
+void axpy(size_t n, float alpha, const float* x, float* y) {
+  kernels<float>().axpy(n, alpha, x, y);
+}
+
+float stridedSum(size_t n, const float* x, size_t stride) {
+  return kernels<float>().strided_sum(n, x, stride);
+}
+
+bool allClose(size_t n, const float* a, const float* b, double eps) {
+  return kernels<float>().all_close(n, a, b, eps);
+}
+
+}  // namespace simd
+}  // namespace task
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+
+namespace task {
+namespace simd {
+
+// Instruction sets with dedicated kernels. The best one supported by the CPU
+// is picked on first use; setLevel() overrides it, clamped to what the CPU
+// supports. Switching is safe while other threads run kernels; each call
+// uses either the old or the new level.
+enum class Level { kScalar, kSse2, kAvx2, kAvx512 };
+
+Level getLevel();
+Level getSupportedLevel();
+void setLevel(Level level);
+
+// Plain loops behind the scalar level and the tails of the vector kernels.
+// They are also the only kernels for element types other than float and
+// double.
+namespace portable {
+
+template <class T>
+void add(size_t n, const T* a, const T* b, T* out) {
+  for (size_t i = 0; i < n; ++i) out[i] = a[i] + b[i];
+}
+
+template <class T>
+void subtract(size_t n, const T* a, const T* b, T* out) {
+  for (size_t i = 0; i < n; ++i) out[i] = a[i] - b[i];
+}
+
+template <class T>
+void scale(size_t n, T alpha, const T* x, T* out) {
+  for (size_t i = 0; i < n; ++i) out[i] = alpha * x[i];
+}
+
+template <class T>
+void negate(size_t n, const T* x, T* out) {
+  for (size_t i = 0; i < n; ++i) out[i] = -x[i];
+}
+
+template <class T>
+void axpy(size_t n, T alpha, const T* x, T* y) {
+  for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+}
+
+template <class T>
+T stridedSum(size_t n, const T* x, size_t stride) {
+  T result = T();
+  for (size_t i = 0; i < n; ++i) result += x[i * stride];
+  return result;
+}
+
+template <class T>
+bool allClose(size_t n, const T* a, const T* b, double eps) {
+  for (size_t i = 0; i < n; ++i) {
+    if (std::abs(a[i] - b[i]) > eps) return false;
+  }
+  return true;
+}
+
+}  // namespace portable
+
+// Elementwise kernels over n contiguous elements. Output may alias an input.
+void add(size_t n, const double* a, const double* b, double* out);
+void add(size_t n, const float* a, const float* b, float* out);
+void subtract(size_t n, const double* a, const double* b, double* out);
+void subtract(size_t n, const float* a, const float* b, float* out);
+void scale(size_t n, double alpha, const double* x, double* out);
+void scale(size_t n, float alpha, const float* x, float* out);
+void negate(size_t n, const double* x, double* out);
+void negate(size_t n, const float* x, float* out);
+void axpy(size_t n, double alpha, const double* x, double* y);
+void axpy(size_t n, float alpha, const float* x, float* y);
+
+// Sum of n elements taken every stride elements, e.g. a matrix diagonal.
+double stridedSum(size_t n, const double* x, size_t stride);
+float stridedSum(size_t n, const float* x, size_t stride);
+
+// True when |a[i] - b[i]| <= eps for every i; stops at the first mismatch.
+bool allClose(size_t n, const double* a, const double* b, double eps);
+bool allClose(size_t n, const float* a, const float* b, double eps);
+
+template <class T>
+void add(size_t n, const T* a, const T* b, T* out) {
+  portable::add(n, a, b, out);
+}
+
+template <class T>
+void subtract(size_t n, const T* a, const T* b, T* out) {
+  portable::subtract(n, a, b, out);
+}
+
+template <class T>
+void scale(size_t n, T alpha, const T* x, T* out) {
+  portable::scale(n, alpha, x, out);
+}
+
+template <class T>
+void negate(size_t n, const T* x, T* out) {
+  portable::negate(n, x, out);
+}
+
+template <class T>
+void axpy(size_t n, T alpha, const T* x, T* y) {
+  portable::axpy(n, alpha, x, y);
+}
+
+template <class T>
+T stridedSum(size_t n, const T* x, size_t stride) {
+  return portable::stridedSum(n, x, stride);
+}
+
+template <class T>
+bool allClose(size_t n, const T* a, const T* b, double eps) {
+  return portable::allClose(n, a, b, eps);
+}
+
+}  // namespace simd
+}  // namespace task
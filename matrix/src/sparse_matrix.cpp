@@ -0,0 +1,331 @@
+#include "sparse_matrix.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "simd.h"
+
+namespace task {
+
+namespace {
+
+std::vector<Triplet> denseEntries(const Matrix& dense, double tolerance,
+                                  bool by_column) {
+  std::vector<Triplet> entries;
+  for (size_t i = 0; i < dense.getRowSize(); ++i) {
+    const double* row = dense[i];
+    for (size_t j = 0; j < dense.getColSize(); ++j) {
+      if (std::abs(row[j]) > tolerance) {
+        entries.push_back(by_column ? Triplet{j, i, row[j]}
+                                    : Triplet{i, j, row[j]});
+      }
+    }
+  }
+  return entries;
+}
+
+std::vector<Triplet> transposedEntries(size_t rows, size_t cols,
+                                       std::vector<Triplet> triplets) {
+  for (Triplet& entry : triplets) {
+    if (entry.row >= rows || entry.col >= cols) {
+      throw OutOfBoundsException();
+    }
+    std::swap(entry.row, entry.col);
+  }
+  return triplets;
+}
+
+}  // namespace
+
+// Entries come in as (outer, inner, value) triplets.
+CompressedStorage CompressedStorage::fromEntries(size_t outer_size,
+                                                 size_t inner_size,
+                                                 std::vector<Triplet> entries) {
+  for (const Triplet& entry : entries) {
+    if (entry.row >= outer_size || entry.col >= inner_size) {
+      throw OutOfBoundsException();
+    }
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Triplet& a, const Triplet& b) {
+              return a.row != b.row ? a.row < b.row : a.col < b.col;
+            });
+  CompressedStorage storage;
+  storage.outer_size = outer_size;
+  storage.inner_size = inner_size;
+  storage.pointers.assign(outer_size + 1, 0);
+  storage.indices.reserve(entries.size());
+  storage.values.reserve(entries.size());
+  for (size_t k = 0; k < entries.size();) {
+    const Triplet& entry = entries[k];
+    double value = 0.0;
+    for (; k < entries.size() && entries[k].row == entry.row &&
+           entries[k].col == entry.col;
+         ++k) {
+      value += entries[k].value;
+    }
+    if (value != 0.0) {
+      storage.indices.push_back(entry.col);
+      storage.values.push_back(value);
+      ++storage.pointers[entry.row + 1];
+    }
+  }
+  for (size_t i = 0; i < outer_size; ++i) {
+    storage.pointers[i + 1] += storage.pointers[i];
+  }
+  return storage;
+}
+
+// Counting sort by inner index: turns CSR into CSC of the same matrix (or
+// into CSR of its transpose) in O(nnz + outer + inner).
+CompressedStorage CompressedStorage::swapped() const {
+  CompressedStorage result;
+  result.outer_size = inner_size;
+  result.inner_size = outer_size;
+  result.pointers.assign(inner_size + 1, 0);
+  result.indices.resize(indices.size());
+  result.values.resize(values.size());
+  for (size_t index : indices) {
+    ++result.pointers[index + 1];
+  }
+  for (size_t i = 0; i < inner_size; ++i) {
+    result.pointers[i + 1] += result.pointers[i];
+  }
+  std::vector<size_t> next(result.pointers.begin(), result.pointers.end() - 1);
+  for (size_t outer = 0; outer < outer_size; ++outer) {
+    for (size_t k = pointers[outer]; k < pointers[outer + 1]; ++k) {
+      size_t position = next[indices[k]]++;
+      result.indices[position] = outer;
+      result.values[position] = values[k];
+    }
+  }
+  return result;
+}
+
+CompressedStorage CompressedStorage::plus(
+    const CompressedStorage& other) const {
+  if (outer_size != other.outer_size || inner_size != other.inner_size) {
+    throw SizeMismatchException();
+  }
+  CompressedStorage result;
+  result.outer_size = outer_size;
+  result.inner_size = inner_size;
+  result.pointers.assign(outer_size + 1, 0);
+  result.indices.reserve(indices.size() + other.indices.size());
+  result.values.reserve(values.size() + other.values.size());
+  for (size_t outer = 0; outer < outer_size; ++outer) {
+    size_t a = pointers[outer];
+    size_t b = other.pointers[outer];
+    size_t a_end = pointers[outer + 1];
+    size_t b_end = other.pointers[outer + 1];
+    while (a < a_end || b < b_end) {
+      size_t index;
+      double value;
+      if (b == b_end || (a < a_end && indices[a] < other.indices[b])) {
+        index = indices[a];
+        value = values[a++];
+      } else if (a == a_end || other.indices[b] < indices[a]) {
+        index = other.indices[b];
+        value = other.values[b++];
+      } else {
+        index = indices[a];
+        value = values[a++] + other.values[b++];
+      }
+      if (value != 0.0) {
+        result.indices.push_back(index);
+        result.values.push_back(value);
+      }
+    }
+    result.pointers[outer + 1] = result.indices.size();
+  }
+  return result;
+}
+
+double CompressedStorage::find(size_t outer, size_t inner) const {
+  if (outer >= outer_size || inner >= inner_size) {
+    throw OutOfBoundsException();
+  }
+  auto first = indices.begin() + pointers[outer];
+  auto last = indices.begin() + pointers[outer + 1];
+  auto position = std::lower_bound(first, last, inner);
+  if (position == last || *position != inner) return 0.0;
+  return values[position - indices.begin()];
+}
+
+CsrMatrix::CsrMatrix(CompressedStorage storage)
+    : storage_(std::move(storage)) {}
+
+CsrMatrix::CsrMatrix(size_t rows, size_t cols)
+    : CsrMatrix(rows, cols, std::vector<Triplet>()) {}
+
+CsrMatrix::CsrMatrix(size_t rows, size_t cols, std::vector<Triplet> triplets)
+    : storage_(CompressedStorage::fromEntries(rows, cols,
+                                              std::move(triplets))) {}
+
+CsrMatrix CsrMatrix::fromDense(const Matrix& dense, double tolerance) {
+  return CsrMatrix(dense.getRowSize(), dense.getColSize(),
+                   denseEntries(dense, tolerance, false));
+}
+
+size_t CsrMatrix::getRowSize() const { return storage_.outer_size; }
+
+size_t CsrMatrix::getColSize() const { return storage_.inner_size; }
+
+size_t CsrMatrix::getNonZeroCount() const { return storage_.values.size(); }
+
+double CsrMatrix::get(size_t row, size_t col) const {
+  return storage_.find(row, col);
+}
+
+const std::vector<size_t>& CsrMatrix::getRowPointers() const {
+  return storage_.pointers;
+}
+
+const std::vector<size_t>& CsrMatrix::getColumnIndices() const {
+  return storage_.indices;
+}
+
+const std::vector<double>& CsrMatrix::getValues() const {
+  return storage_.values;
+}
+
+std::vector<double> CsrMatrix::operator*(const std::vector<double>& x) const {
+  if (x.size() != getColSize()) {
+    throw SizeMismatchException();
+  }
+  std::vector<double> y(getRowSize());
+  for (size_t i = 0; i < getRowSize(); ++i) {
+    double sum = 0.0;
+    for (size_t k = storage_.pointers[i]; k < storage_.pointers[i + 1]; ++k) {
+      sum += storage_.values[k] * x[storage_.indices[k]];
+    }
+    y[i] = sum;
+  }
+  return y;
+}
+
+Matrix CsrMatrix::operator*(const Matrix& dense) const {
+  if (dense.getRowSize() != getColSize()) {
+    throw SizeMismatchException();
+  }
+  size_t cols = dense.getColSize();
+  Matrix result(getRowSize(), cols);
+  for (size_t i = 0; i < getRowSize(); ++i) {
+    double* row = result[i];
+    std::fill(row, row + cols, 0.0);
+    for (size_t k = storage_.pointers[i]; k < storage_.pointers[i + 1]; ++k) {
+      simd::axpy(cols, storage_.values[k], dense[storage_.indices[k]], row);
+    }
+  }
+  return result;
+}
+
+CsrMatrix CsrMatrix::operator+(const CsrMatrix& other) const {
+  return CsrMatrix(storage_.plus(other.storage_));
+}
+
+CsrMatrix CsrMatrix::transposed() const {
+  return CsrMatrix(storage_.swapped());
+}
+
+CscMatrix CsrMatrix::toCsc() const { return CscMatrix(storage_.swapped()); }
+
+Matrix CsrMatrix::toDense() const {
+  Matrix result(getRowSize(), getColSize());
+  for (size_t i = 0; i < getRowSize(); ++i) {
+    double* row = result[i];
+    std::fill(row, row + getColSize(), 0.0);
+    for (size_t k = storage_.pointers[i]; k < storage_.pointers[i + 1]; ++k) {
+      row[storage_.indices[k]] = storage_.values[k];
+    }
+  }
+  return result;
+}
+
+CscMatrix::CscMatrix(CompressedStorage storage)
+    : storage_(std::move(storage)) {}
+
+CscMatrix::CscMatrix(size_t rows, size_t cols)
+    : CscMatrix(rows, cols, std::vector<Triplet>()) {}
+
+CscMatrix::CscMatrix(size_t rows, size_t cols, std::vector<Triplet> triplets)
+    : storage_(CompressedStorage::fromEntries(
+          cols, rows, transposedEntries(rows, cols, std::move(triplets)))) {}
+
+CscMatrix CscMatrix::fromDense(const Matrix& dense, double tolerance) {
+  return CscMatrix(CompressedStorage::fromEntries(
+      dense.getColSize(), dense.getRowSize(),
+      denseEntries(dense, tolerance, true)));
+}
+
+size_t CscMatrix::getRowSize() const { return storage_.inner_size; }
+
+size_t CscMatrix::getColSize() const { return storage_.outer_size; }
+
+size_t CscMatrix::getNonZeroCount() const { return storage_.values.size(); }
+
+double CscMatrix::get(size_t row, size_t col) const {
+  if (row >= getRowSize()) {
+    throw OutOfBoundsException();
+  }
+  return storage_.find(col, row);
+}
+
+const std::vector<size_t>& CscMatrix::getColumnPointers() const {
+  return storage_.pointers;
+}
+
+const std::vector<size_t>& CscMatrix::getRowIndices() const {
+  return storage_.indices;
+}
+
+const std::vector<double>& CscMatrix::getValues() const {
+  return storage_.values;
+}
+
+std::vector<double> CscMatrix::operator*(const std::vector<double>& x) const {
+  if (x.size() != getColSize()) {
+    throw SizeMismatchException();
+  }
+  std::vector<double> y(getRowSize(), 0.0);
+  for (size_t j = 0; j < getColSize(); ++j) {
+    for (size_t k = storage_.pointers[j]; k < storage_.pointers[j + 1]; ++k) {
+      y[storage_.indices[k]] += storage_.values[k] * x[j];
+    }
+  }
+  return y;
+}
+
+CscMatrix CscMatrix::operator+(const CscMatrix& other) const {
+  return CscMatrix(storage_.plus(other.storage_));
+}
+
+CscMatrix CscMatrix::transposed() const {
+  return CscMatrix(storage_.swapped());
+}
+
+CsrMatrix CscMatrix::toCsr() const { return CsrMatrix(storage_.swapped()); }
+
+Matrix CscMatrix::toDense() const { return toCsr().toDense(); }
+
+Matrix operator*(const Matrix& dense, const CscMatrix& sparse) {
+  if (dense.getColSize() != sparse.getRowSize()) {
+    throw SizeMismatchException();
+  }
+  const CompressedStorage& storage = sparse.storage_;
+  Matrix result(dense.getRowSize(), sparse.getColSize());
+  for (size_t i = 0; i < dense.getRowSize(); ++i) {
+    const double* source = dense[i];
+    double* row = result[i];
+    for (size_t j = 0; j < sparse.getColSize(); ++j) {
+      double sum = 0.0;
+      for (size_t k = storage.pointers[j]; k < storage.pointers[j + 1]; ++k) {
+        sum += source[storage.indices[k]] * storage.values[k];
+      }
+      row[j] = sum;
+    }
+  }
+  return result;
+}
+
+}  // namespace task
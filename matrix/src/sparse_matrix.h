@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "matrix.h"
+
+namespace task {
+
+struct Triplet {
+  size_t row;
+  size_t col;
+  double value;
+};
+
+// Compressed storage shared by CSR and CSC: entries of outer line i are
+// indices[pointers[i]..pointers[i + 1]) with matching values, sorted and
+// unique within a line. CSR uses rows as outer lines, CSC uses columns.
+// Exact zeros are never stored: construction and plus() drop entries that
+// are, or sum to, zero.
+struct CompressedStorage {
+  size_t outer_size = 0;
+  size_t inner_size = 0;
+  std::vector<size_t> pointers;
+  std::vector<size_t> indices;
+  std::vector<double> values;
+
+  static CompressedStorage fromEntries(size_t outer_size, size_t inner_size,
+                                       std::vector<Triplet> entries);
+  CompressedStorage swapped() const;
+  CompressedStorage plus(const CompressedStorage& other) const;
+  double find(size_t outer, size_t inner) const;
+};
+
+class CscMatrix;
+
+class CsrMatrix {
+ public:
+  CsrMatrix(size_t rows, size_t cols);
+  // Duplicate entries are summed; zero sums are dropped.
+  CsrMatrix(size_t rows, size_t cols, std::vector<Triplet> triplets);
+  static CsrMatrix fromDense(const Matrix& dense, double tolerance = 0.0);
+
+  size_t getRowSize() const;
+  size_t getColSize() const;
+  size_t getNonZeroCount() const;
+  double get(size_t row, size_t col) const;
+  const std::vector<size_t>& getRowPointers() const;
+  const std::vector<size_t>& getColumnIndices() const;
+  const std::vector<double>& getValues() const;
+
+  std::vector<double> operator*(const std::vector<double>& x) const;
+  Matrix operator*(const Matrix& dense) const;
+  CsrMatrix operator+(const CsrMatrix& other) const;
+
+  CsrMatrix transposed() const;
+  CscMatrix toCsc() const;
+  Matrix toDense() const;
+
+ private:
+  friend class CscMatrix;
+  explicit CsrMatrix(CompressedStorage storage);
+
+  CompressedStorage storage_;
+};
+
+class CscMatrix {
+ public:
+  CscMatrix(size_t rows, size_t cols);
+  // Duplicate entries are summed; zero sums are dropped.
+  CscMatrix(size_t rows, size_t cols, std::vector<Triplet> triplets);
+  static CscMatrix fromDense(const Matrix& dense, double tolerance = 0.0);
+
+  size_t getRowSize() const;
+  size_t getColSize() const;
+  size_t getNonZeroCount() const;
+  double get(size_t row, size_t col) const;
+  const std::vector<size_t>& getColumnPointers() const;
+  const std::vector<size_t>& getRowIndices() const;
+  const std::vector<double>& getValues() const;
+
+  std::vector<double> operator*(const std::vector<double>& x) const;
+  CscMatrix operator+(const CscMatrix& other) const;
+
+  CscMatrix transposed() const;
+  CsrMatrix toCsr() const;
+  Matrix toDense() const;
+
+ private:
+  friend class CsrMatrix;
+  friend Matrix operator*(const Matrix& dense, const CscMatrix& sparse);
+  explicit CscMatrix(CompressedStorage storage);
+
+  CompressedStorage storage_;
+};
+
+Matrix operator*(const Matrix& dense, const CscMatrix& sparse);
+
+}  // namespace task
@@ -0,0 +1,159 @@
+#include "strassen.h"
+
+#include "gemm.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace task {
+
+namespace {
+
+// C = A * B + beta * C through the packed kernel.
+void gemmInto(const ConstMatrixView& a, const ConstMatrixView& b, double beta,
+              const MatrixView& c) {
+  gemm(a.getRowSize(), b.getColSize(), a.getColSize(), 1.0, a.data(),
+       a.getRowStride(), a.getColStride(), b.data(), b.getRowStride(),
+       b.getColStride(), beta, c.data(), c.getRowStride());
+}
+
+// Out = X + Y or X - Y. Out may be X or Y.
+void combine(const ConstMatrixView& x, const ConstMatrixView& y, bool subtract,
+             const MatrixView& out) {
+  size_t rows = out.getRowSize();
+  size_t cols = out.getColSize();
+  for (size_t i = 0; i < rows; ++i) {
+    double* target = out.data() + i * out.getRowStride();
+    if (x.getColStride() == 1 && y.getColStride() == 1) {
+      const double* x_row = x.data() + i * x.getRowStride();
+      const double* y_row = y.data() + i * y.getRowStride();
+      if (subtract) {
+        simd::subtract(cols, x_row, y_row, target);
+      } else {
+        simd::add(cols, x_row, y_row, target);
+      }
+      continue;
+    }
+    for (size_t j = 0; j < cols; ++j) {
+      target[j] = subtract ? x.coeff(i, j) - y.coeff(i, j)
+                           : x.coeff(i, j) + y.coeff(i, j);
+    }
+  }
+}
+
+class Strassen {
+ public:
+  explicit Strassen(size_t cutoff) : cutoff_(std::max<size_t>(cutoff, 2)) {}
+
+  // Doubles needed below a product of this shape, every level included.
+  size_t workspaceSize(size_t m, size_t k, size_t n) const {
+    if (isBase(m, k, n)) return 0;
+    m /= 2;
+    k /= 2;
+    n /= 2;
+    return m * std::max(k, n) + k * n + workspaceSize(m, k, n);
+  }
+
+  // C = A * B, with C holding no other operand.
+  void multiply(const ConstMatrixView& a, const ConstMatrixView& b,
+                const MatrixView& c, double* workspace) const {
+    size_t m = a.getRowSize();
+    size_t k = a.getColSize();
+    size_t n = b.getColSize();
+    if (isBase(m, k, n)) {
+      gemmInto(a, b, 0.0, c);
+      return;
+    }
+    size_t even_m = m & ~size_t(1);
+    size_t even_k = k & ~size_t(1);
+    size_t even_n = n & ~size_t(1);
+    ConstMatrixView a_left = a.block(0, 0, even_m, k);
+    multiplyEven(a.block(0, 0, even_m, even_k), b.block(0, 0, even_k, even_n),
+                 c.block(0, 0, even_m, even_n), workspace);
+    if (even_k < k) {
+      gemmInto(a.block(0, even_k, even_m, 1), b.block(even_k, 0, 1, even_n),
+               1.0, c.block(0, 0, even_m, even_n));
+    }
+    if (even_n < n) {
+      gemmInto(a_left, b.block(0, even_n, k, 1), 0.0,
+               c.block(0, even_n, even_m, 1));
+    }
+    if (even_m < m) {
+      gemmInto(a.block(even_m, 0, 1, k), b, 0.0, c.block(even_m, 0, 1, n));
+    }
+  }
+
+ private:
+  bool isBase(size_t m, size_t k, size_t n) const {
+    return std::min({m, k, n}) < cutoff_;
+  }
+
+  // One level for even sides, scheduled so that two temporaries and the
+  // quadrants of C hold every intermediate (Boyer, Dumas, Pernet and Zhou).
+  void multiplyEven(const ConstMatrixView& a, const ConstMatrixView& b,
+                    const MatrixView& c, double* workspace) const {
+    size_t m = a.getRowSize() / 2;
+    size_t k = a.getColSize() / 2;
+    size_t n = b.getColSize() / 2;
+    ConstMatrixView a11 = a.block(0, 0, m, k);
+    ConstMatrixView a12 = a.block(0, k, m, k);
+    ConstMatrixView a21 = a.block(m, 0, m, k);
+    ConstMatrixView a22 = a.block(m, k, m, k);
+    ConstMatrixView b11 = b.block(0, 0, k, n);
+    ConstMatrixView b12 = b.block(0, n, k, n);
+    ConstMatrixView b21 = b.block(k, 0, k, n);
+    ConstMatrixView b22 = b.block(k, n, k, n);
+    MatrixView c11 = c.block(0, 0, m, n);
+    MatrixView c12 = c.block(0, n, m, n);
+    MatrixView c21 = c.block(m, 0, m, n);
+    MatrixView c22 = c.block(m, n, m, n);
+    MatrixView s(workspace, m, k, k, 1);
+    MatrixView p1(workspace, m, n, n, 1);
+    double* y_data = workspace + m * std::max(k, n);
+    MatrixView t(y_data, k, n, n, 1);
+    double* rest = y_data + k * n;
+
+    combine(a11, a21, true, s);
+    combine(b22, b12, true, t);
+    multiply(s, t, c21, rest);  // P7
+    combine(a21, a22, false, s);
+    combine(b12, b11, true, t);
+    multiply(s, t, c22, rest);  // P5
+    combine(s, a11, true, s);
+    combine(b22, t, true, t);
+    multiply(s, t, c12, rest);  // P6
+    combine(a12, s, true, s);
+    multiply(s, b22, c11, rest);  // P3
+    multiply(a11, b11, p1, rest);
+    combine(p1, c12, false, c12);
+    combine(c12, c21, false, c21);
+    combine(c12, c22, false, c12);
+    combine(c21, c22, false, c22);
+    combine(c12, c11, false, c12);
+    combine(t, b21, true, t);
+    multiply(a22, t, c11, rest);  // P4
+    combine(c21, c11, true, c21);
+    multiply(a12, b21, c11, rest);  // P2
+    combine(p1, c11, false, c11);
+  }
+
+  size_t cutoff_;
+};
+
+}  // namespace
+
+Matrix strassenMultiply(const ConstMatrixView& a, const ConstMatrixView& b,
+                        size_t cutoff) {
+  if (a.getColSize() != b.getRowSize()) {
+    throw SizeMismatchException();
+  }
+  Matrix result(a.getRowSize(), b.getColSize());
+  Strassen strassen(cutoff);
+  std::vector<double> workspace(strassen.workspaceSize(
+      a.getRowSize(), a.getColSize(), b.getColSize()));
+  strassen.multiply(a, b, result, workspace.data());
+  return result;
+}
+
+}  // namespace task
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "matrix.h"
+
+namespace task {
+
+// Side length below which the packed gemm kernel beats another level of
+// recursion.
+const size_t kStrassenCutoff = 512;
+
+// A * B by the Strassen-Winograd scheme: seven half-size products and fifteen
+// additions per level, recursing until a side drops below cutoff. Odd sides
+// are peeled off and fixed up with gemm, and one workspace allocated up front
+// serves every level. Worth it only for products of a few thousand on a side;
+// rounding error grows slightly faster than with multiply().
+Matrix strassenMultiply(const ConstMatrixView& a, const ConstMatrixView& b,
+                        size_t cutoff = kStrassenCutoff);
+
+}  // namespace task
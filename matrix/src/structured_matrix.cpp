@@ -0,0 +1,573 @@
+#include "structured_matrix.h"
+
+#include <algorithm>
+
+#include "simd.h"
+
+namespace task {
+
+namespace {
+
+Matrix zeroMatrix(size_t rows, size_t cols) {
+  Matrix result(rows, cols);
+  std::fill_n(result[0], rows * cols, 0.0);
+  return result;
+}
+
+void checkSquare(const Matrix& dense) {
+  if (dense.getRowSize() != dense.getColSize()) {
+    throw SizeMismatchException();
+  }
+}
+
+void checkIndex(size_t index, size_t size) {
+  if (index >= size) {
+    throw OutOfBoundsException();
+  }
+}
+
+double checkedReciprocal(double value) {
+  if (value == 0.0) {
+    throw SingularMatrixException();
+  }
+  return 1.0 / value;
+}
+
+// y = S x for a symmetric S packed as its lower triangle by rows. Every
+// stored entry below the diagonal is used twice.
+void symmetricTimes(size_t size, const double* packed, const double* x,
+                    double* y) {
+  std::fill(y, y + size, 0.0);
+  for (size_t i = 0; i < size; ++i) {
+    const double* row = packed + i * (i + 1) / 2;
+    double sum = 0.0;
+    for (size_t j = 0; j < i; ++j) {
+      sum += row[j] * x[j];
+      y[j] += row[j] * x[i];
+    }
+    y[i] += sum + row[i] * x[i];
+  }
+}
+
+}  // namespace
+
+DiagonalMatrix::DiagonalMatrix(size_t size) : diagonal_(size, 1.0) {}
+
+DiagonalMatrix::DiagonalMatrix(std::vector<double> diagonal)
+    : diagonal_(std::move(diagonal)) {}
+
+DiagonalMatrix DiagonalMatrix::fromDense(const Matrix& dense) {
+  checkSquare(dense);
+  std::vector<double> diagonal(dense.getRowSize());
+  for (size_t i = 0; i < diagonal.size(); ++i) {
+    diagonal[i] = dense[i][i];
+  }
+  return DiagonalMatrix(std::move(diagonal));
+}
+
+size_t DiagonalMatrix::getSize() const { return diagonal_.size(); }
+
+double DiagonalMatrix::get(size_t row, size_t col) const {
+  checkIndex(row, getSize());
+  checkIndex(col, getSize());
+  return row == col ? diagonal_[row] : 0.0;
+}
+
+void DiagonalMatrix::set(size_t index, double value) {
+  checkIndex(index, getSize());
+  diagonal_[index] = value;
+}
+
+const std::vector<double>& DiagonalMatrix::getDiagonal() const {
+  return diagonal_;
+}
+
+double DiagonalMatrix::det() const {
+  double result = 1.0;
+  for (double value : diagonal_) {
+    result *= value;
+  }
+  return result;
+}
+
+DiagonalMatrix DiagonalMatrix::inverse() const {
+  std::vector<double> diagonal(getSize());
+  for (size_t i = 0; i < getSize(); ++i) {
+    diagonal[i] = checkedReciprocal(diagonal_[i]);
+  }
+  return DiagonalMatrix(std::move(diagonal));
+}
+
+std::vector<double> DiagonalMatrix::solve(const std::vector<double>& b) const {
+  if (b.size() != getSize()) {
+    throw SizeMismatchException();
+  }
+  std::vector<double> x(getSize());
+  for (size_t i = 0; i < getSize(); ++i) {
+    x[i] = b[i] * checkedReciprocal(diagonal_[i]);
+  }
+  return x;
+}
+
+Matrix DiagonalMatrix::solve(const Matrix& b) const {
+  return inverse() * b;
+}
+
+std::vector<double> DiagonalMatrix::operator*(
+    const std::vector<double>& x) const {
+  if (x.size() != getSize()) {
+    throw SizeMismatchException();
+  }
+  std::vector<double> y(getSize());
+  for (size_t i = 0; i < getSize(); ++i) {
+    y[i] = diagonal_[i] * x[i];
+  }
+  return y;
+}
+
+Matrix DiagonalMatrix::operator*(const Matrix& dense) const {
+  if (dense.getRowSize() != getSize()) {
+    throw SizeMismatchException();
+  }
+  size_t cols = dense.getColSize();
+  Matrix result(getSize(), cols);
+  for (size_t i = 0; i < getSize(); ++i) {
+    simd::scale(cols, diagonal_[i], dense[i], result[i]);
+  }
+  return result;
+}
+
+DiagonalMatrix DiagonalMatrix::operator*(const DiagonalMatrix& other) const {
+  if (other.getSize() != getSize()) {
+    throw SizeMismatchException();
+  }
+  std::vector<double> diagonal(getSize());
+  for (size_t i = 0; i < getSize(); ++i) {
+    diagonal[i] = diagonal_[i] * other.diagonal_[i];
+  }
+  return DiagonalMatrix(std::move(diagonal));
+}
+
+Matrix DiagonalMatrix::toDense() const {
+  Matrix result = zeroMatrix(getSize(), getSize());
+  for (size_t i = 0; i < getSize(); ++i) {
+    result[i][i] = diagonal_[i];
+  }
+  return result;
+}
+
+Matrix operator*(const Matrix& dense, const DiagonalMatrix& diagonal) {
+  if (dense.getColSize() != diagonal.getSize()) {
+    throw SizeMismatchException();
+  }
+  const double* scale = diagonal.getDiagonal().data();
+  size_t cols = diagonal.getSize();
+  Matrix result(dense.getRowSize(), cols);
+  for (size_t i = 0; i < dense.getRowSize(); ++i) {
+    const double* source = dense[i];
+    double* row = result[i];
+    for (size_t j = 0; j < cols; ++j) {
+      row[j] = source[j] * scale[j];
+    }
+  }
+  return result;
+}
+
+TriangularMatrix::TriangularMatrix(size_t size, Triangle triangle)
+    : size_(size), triangle_(triangle), values_(size * (size + 1) / 2) {
+  for (size_t i = 0; i < size; ++i) {
+    rowData(i)[i - rowBegin(i)] = 1.0;
+  }
+}
+
+TriangularMatrix TriangularMatrix::fromDense(const Matrix& dense,
+                                             Triangle triangle) {
+  checkSquare(dense);
+  TriangularMatrix result(dense.getRowSize(), triangle);
+  for (size_t i = 0; i < result.size_; ++i) {
+    size_t begin = result.rowBegin(i);
+    std::copy(dense[i] + begin, dense[i] + result.rowEnd(i),
+              result.rowData(i));
+  }
+  return result;
+}
+
+size_t TriangularMatrix::getSize() const { return size_; }
+
+Triangle TriangularMatrix::getTriangle() const { return triangle_; }
+
+bool TriangularMatrix::isStored(size_t row, size_t col) const {
+  return triangle_ == Triangle::kLower ? col <= row : col >= row;
+}
+
+size_t TriangularMatrix::rowBegin(size_t row) const {
+  return triangle_ == Triangle::kLower ? 0 : row;
+}
+
+size_t TriangularMatrix::rowEnd(size_t row) const {
+  return triangle_ == Triangle::kLower ? row + 1 : size_;
+}
+
+const double* TriangularMatrix::rowData(size_t row) const {
+  size_t offset = triangle_ == Triangle::kLower
+                      ? row * (row + 1) / 2
+                      : row * size_ - row * (row - 1) / 2;
+  return values_.data() + offset;
+}
+
+double* TriangularMatrix::rowData(size_t row) {
+  return const_cast<double*>(
+      static_cast<const TriangularMatrix&>(*this).rowData(row));
+}
+
+double TriangularMatrix::get(size_t row, size_t col) const {
+  checkIndex(row, size_);
+  checkIndex(col, size_);
+  return isStored(row, col) ? rowData(row)[col - rowBegin(row)] : 0.0;
+}
+
+void TriangularMatrix::set(size_t row, size_t col, double value) {
+  checkIndex(row, size_);
+  checkIndex(col, size_);
+  if (!isStored(row, col)) {
+    throw OutOfBoundsException();
+  }
+  rowData(row)[col - rowBegin(row)] = value;
+}
+
+double TriangularMatrix::det() const {
+  double result = 1.0;
+  for (size_t i = 0; i < size_; ++i) {
+    result *= rowData(i)[i - rowBegin(i)];
+  }
+  return result;
+}
+
+std::vector<double> TriangularMatrix::solve(
+    const std::vector<double>& b) const {
+  if (b.size() != size_) {
+    throw SizeMismatchException();
+  }
+  Matrix column(size_, 1);
+  for (size_t i = 0; i < size_; ++i) {
+    column[i][0] = b[i];
+  }
+  column = solve(column);
+  return column.getColumn(0);
+}
+
+// Row i of X is B_i minus the already solved rows weighted by row i of the
+// matrix, over its diagonal entry: rows go top-down for a lower matrix and
+// bottom-up for an upper one.
+Matrix TriangularMatrix::solve(const Matrix& b) const {
+  if (b.getRowSize() != size_) {
+    throw SizeMismatchException();
+  }
+  size_t cols = b.getColSize();
+  Matrix x = b;
+  for (size_t step = 0; step < size_; ++step) {
+    size_t i = triangle_ == Triangle::kLower ? step : size_ - 1 - step;
+    const double* row = rowData(i) - rowBegin(i);
+    double* target = x[i];
+    for (size_t j = rowBegin(i); j < rowEnd(i); ++j) {
+      if (j != i) {
+        simd::axpy(cols, -row[j], x[j], target);
+      }
+    }
+    simd::scale(cols, checkedReciprocal(row[i]), target, target);
+  }
+  return x;
+}
+
+std::vector<double> TriangularMatrix::operator*(
+    const std::vector<double>& x) const {
+  if (x.size() != size_) {
+    throw SizeMismatchException();
+  }
+  std::vector<double> y(size_);
+  for (size_t i = 0; i < size_; ++i) {
+    const double* row = rowData(i) - rowBegin(i);
+    double sum = 0.0;
+    for (size_t j = rowBegin(i); j < rowEnd(i); ++j) {
+      sum += row[j] * x[j];
+    }
+    y[i] = sum;
+  }
+  return y;
+}
+
+Matrix TriangularMatrix::operator*(const Matrix& dense) const {
+  if (dense.getRowSize() != size_) {
+    throw SizeMismatchException();
+  }
+  size_t cols = dense.getColSize();
+  Matrix result = zeroMatrix(size_, cols);
+  for (size_t i = 0; i < size_; ++i) {
+    const double* row = rowData(i) - rowBegin(i);
+    for (size_t j = rowBegin(i); j < rowEnd(i); ++j) {
+      simd::axpy(cols, row[j], dense[j], result[i]);
+    }
+  }
+  return result;
+}
+
+TriangularMatrix TriangularMatrix::transposed() const {
+  TriangularMatrix result(size_, triangle_ == Triangle::kLower
+                                     ? Triangle::kUpper
+                                     : Triangle::kLower);
+  for (size_t i = 0; i < size_; ++i) {
+    for (size_t j = rowBegin(i); j < rowEnd(i); ++j) {
+      result.set(j, i, get(i, j));
+    }
+  }
+  return result;
+}
+
+Matrix TriangularMatrix::toDense() const {
+  Matrix result = zeroMatrix(size_, size_);
+  for (size_t i = 0; i < size_; ++i) {
+    std::copy(rowData(i), rowData(i) + rowEnd(i) - rowBegin(i),
+              result[i] + rowBegin(i));
+  }
+  return result;
+}
+
+// Row r of the product adds row j of the triangle, scaled by entry (r, j)
+// of the dense matrix, over the columns that row stores.
+Matrix operator*(const Matrix& dense, const TriangularMatrix& triangular) {
+  size_t size = triangular.getSize();
+  if (dense.getColSize() != size) {
+    throw SizeMismatchException();
+  }
+  Matrix result = zeroMatrix(dense.getRowSize(), size);
+  for (size_t r = 0; r < dense.getRowSize(); ++r) {
+    const double* source = dense[r];
+    double* row = result[r];
+    for (size_t j = 0; j < size; ++j) {
+      size_t begin = triangular.rowBegin(j);
+      simd::axpy(triangular.rowEnd(j) - begin, source[j],
+                 triangular.rowData(j), row + begin);
+    }
+  }
+  return result;
+}
+
+SymmetricMatrix::SymmetricMatrix(size_t size)
+    : size_(size), values_(size * (size + 1) / 2) {
+  for (size_t i = 0; i < size; ++i) {
+    values_[index(i, i)] = 1.0;
+  }
+}
+
+SymmetricMatrix SymmetricMatrix::fromDense(const Matrix& dense) {
+  checkSquare(dense);
+  SymmetricMatrix result(dense.getRowSize());
+  for (size_t i = 0; i < result.size_; ++i) {
+    std::copy(dense[i], dense[i] + i + 1,
+              result.values_.begin() + result.index(i, 0));
+  }
+  return result;
+}
+
+size_t SymmetricMatrix::getSize() const { return size_; }
+
+size_t SymmetricMatrix::index(size_t row, size_t col) const {
+  if (col > row) {
+    std::swap(row, col);
+  }
+  return row * (row + 1) / 2 + col;
+}
+
+double SymmetricMatrix::get(size_t row, size_t col) const {
+  checkIndex(row, size_);
+  checkIndex(col, size_);
+  return values_[index(row, col)];
+}
+
+void SymmetricMatrix::set(size_t row, size_t col, double value) {
+  checkIndex(row, size_);
+  checkIndex(col, size_);
+  values_[index(row, col)] = value;
+}
+
+std::vector<double> SymmetricMatrix::operator*(
+    const std::vector<double>& x) const {
+  if (x.size() != size_) {
+    throw SizeMismatchException();
+  }
+  std::vector<double> y(size_);
+  symmetricTimes(size_, values_.data(), x.data(), y.data());
+  return y;
+}
+
+Matrix SymmetricMatrix::operator*(const Matrix& dense) const {
+  if (dense.getRowSize() != size_) {
+    throw SizeMismatchException();
+  }
+  size_t cols = dense.getColSize();
+  Matrix result = zeroMatrix(size_, cols);
+  for (size_t i = 0; i < size_; ++i) {
+    const double* row = values_.data() + index(i, 0);
+    for (size_t j = 0; j < i; ++j) {
+      simd::axpy(cols, row[j], dense[j], result[i]);
+      simd::axpy(cols, row[j], dense[i], result[j]);
+    }
+    simd::axpy(cols, row[i], dense[i], result[i]);
+  }
+  return result;
+}
+
+Matrix SymmetricMatrix::toDense() const {
+  Matrix result(size_, size_);
+  for (size_t i = 0; i < size_; ++i) {
+    for (size_t j = 0; j <= i; ++j) {
+      result[i][j] = result[j][i] = values_[index(i, j)];
+    }
+  }
+  return result;
+}
+
+// Row r of the product is S times row r of the dense matrix.
+Matrix operator*(const Matrix& dense, const SymmetricMatrix& symmetric) {
+  size_t size = symmetric.getSize();
+  if (dense.getColSize() != size) {
+    throw SizeMismatchException();
+  }
+  Matrix result(dense.getRowSize(), size);
+  for (size_t r = 0; r < dense.getRowSize(); ++r) {
+    symmetricTimes(size, symmetric.values_.data(), dense[r], result[r]);
+  }
+  return result;
+}
+
+BandedMatrix::BandedMatrix(size_t size, size_t lower, size_t upper)
+    : size_(size),
+      lower_(lower),
+      upper_(upper),
+      values_(size * (lower + upper + 1)) {
+  for (size_t i = 0; i < size; ++i) {
+    values_[index(i, i)] = 1.0;
+  }
+}
+
+BandedMatrix BandedMatrix::fromDense(const Matrix& dense, size_t lower,
+                                     size_t upper) {
+  checkSquare(dense);
+  BandedMatrix result(dense.getRowSize(), lower, upper);
+  for (size_t i = 0; i < result.size_; ++i) {
+    size_t begin = result.rowBegin(i);
+    std::copy(dense[i] + begin, dense[i] + result.rowEnd(i),
+              result.values_.begin() + result.index(i, begin));
+  }
+  return result;
+}
+
+size_t BandedMatrix::getSize() const { return size_; }
+
+size_t BandedMatrix::getLowerBandwidth() const { return lower_; }
+
+size_t BandedMatrix::getUpperBandwidth() const { return upper_; }
+
+bool BandedMatrix::isStored(size_t row, size_t col) const {
+  return row <= col + lower_ && col <= row + upper_;
+}
+
+size_t BandedMatrix::rowBegin(size_t row) const {
+  return row > lower_ ? row - lower_ : 0;
+}
+
+size_t BandedMatrix::rowEnd(size_t row) const {
+  return std::min(size_, row + upper_ + 1);
+}
+
+size_t BandedMatrix::index(size_t row, size_t col) const {
+  return row * (lower_ + upper_ + 1) + col + lower_ - row;
+}
+
+double BandedMatrix::get(size_t row, size_t col) const {
+  checkIndex(row, size_);
+  checkIndex(col, size_);
+  return isStored(row, col) ? values_[index(row, col)] : 0.0;
+}
+
+void BandedMatrix::set(size_t row, size_t col, double value) {
+  checkIndex(row, size_);
+  checkIndex(col, size_);
+  if (!isStored(row, col)) {
+    throw OutOfBoundsException();
+  }
+  values_[index(row, col)] = value;
+}
+
+std::vector<double> BandedMatrix::operator*(
+    const std::vector<double>& x) const {
+  if (x.size() != size_) {
+    throw SizeMismatchException();
+  }
+  std::vector<double> y(size_);
+  for (size_t i = 0; i < size_; ++i) {
+    double sum = 0.0;
+    for (size_t j = rowBegin(i); j < rowEnd(i); ++j) {
+      sum += values_[index(i, j)] * x[j];
+    }
+    y[i] = sum;
+  }
+  return y;
+}
+
+Matrix BandedMatrix::operator*(const Matrix& dense) const {
+  if (dense.getRowSize() != size_) {
+    throw SizeMismatchException();
+  }
+  size_t cols = dense.getColSize();
+  Matrix result = zeroMatrix(size_, cols);
+  for (size_t i = 0; i < size_; ++i) {
+    for (size_t j = rowBegin(i); j < rowEnd(i); ++j) {
+      simd::axpy(cols, values_[index(i, j)], dense[j], result[i]);
+    }
+  }
+  return result;
+}
+
+BandedMatrix BandedMatrix::transposed() const {
+  BandedMatrix result(size_, upper_, lower_);
+  for (size_t i = 0; i < size_; ++i) {
+    for (size_t j = rowBegin(i); j < rowEnd(i); ++j) {
+      result.values_[result.index(j, i)] = values_[index(i, j)];
+    }
+  }
+  return result;
+}
+
+Matrix BandedMatrix::toDense() const {
+  Matrix result = zeroMatrix(size_, size_);
+  for (size_t i = 0; i < size_; ++i) {
+    for (size_t j = rowBegin(i); j < rowEnd(i); ++j) {
+      result[i][j] = values_[index(i, j)];
+    }
+  }
+  return result;
+}
+
+// Row r of the product adds the stored part of row j, scaled by entry (r, j)
+// of the dense matrix.
+Matrix operator*(const Matrix& dense, const BandedMatrix& banded) {
+  size_t size = banded.getSize();
+  if (dense.getColSize() != size) {
+    throw SizeMismatchException();
+  }
+  Matrix result = zeroMatrix(dense.getRowSize(), size);
+  for (size_t r = 0; r < dense.getRowSize(); ++r) {
+    const double* source = dense[r];
+    double* row = result[r];
+    for (size_t j = 0; j < size; ++j) {
+      size_t begin = banded.rowBegin(j);
+      simd::axpy(banded.rowEnd(j) - begin, source[j],
+                 banded.values_.data() + banded.index(j, begin),
+                 row + begin);
+    }
+  }
+  return result;
+}
+
+}  // namespace task
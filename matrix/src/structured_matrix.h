@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "factorization.h"
+#include "matrix.h"
+
+namespace task {
+
+// Square matrices that store only the entries their structure allows. Like
+// Matrix, a new one is the identity. get() reads any entry; set() of an entry
+// outside the structure throws OutOfBoundsException. Products with a dense
+// Matrix touch stored entries only.
+
+class DiagonalMatrix {
+ public:
+  explicit DiagonalMatrix(size_t size);
+  explicit DiagonalMatrix(std::vector<double> diagonal);
+  // Keeps the diagonal of a square matrix.
+  static DiagonalMatrix fromDense(const Matrix& dense);
+
+  size_t getSize() const;
+  double get(size_t row, size_t col) const;
+  void set(size_t index, double value);
+  const std::vector<double>& getDiagonal() const;
+
+  double det() const;
+  // Throws SingularMatrixException on a zero diagonal entry.
+  DiagonalMatrix inverse() const;
+  std::vector<double> solve(const std::vector<double>& b) const;
+  Matrix solve(const Matrix& b) const;
+
+  std::vector<double> operator*(const std::vector<double>& x) const;
+  Matrix operator*(const Matrix& dense) const;
+  DiagonalMatrix operator*(const DiagonalMatrix& other) const;
+
+  Matrix toDense() const;
+
+ private:
+  std::vector<double> diagonal_;
+};
+
+Matrix operator*(const Matrix& dense, const DiagonalMatrix& diagonal);
+
+enum class Triangle { kLower, kUpper };
+
+// Packed by rows: row i of a lower matrix holds columns 0..i, row i of an
+// upper one columns i..n-1.
+class TriangularMatrix {
+ public:
+  TriangularMatrix(size_t size, Triangle triangle);
+  // Reads only the given triangle of a square matrix.
+  static TriangularMatrix fromDense(const Matrix& dense, Triangle triangle);
+
+  size_t getSize() const;
+  Triangle getTriangle() const;
+  double get(size_t row, size_t col) const;
+  void set(size_t row, size_t col, double value);
+
+  double det() const;
+  // Forward or back substitution. Throws SingularMatrixException on a zero
+  // diagonal entry.
+  std::vector<double> solve(const std::vector<double>& b) const;
+  Matrix solve(const Matrix& b) const;
+
+  std::vector<double> operator*(const std::vector<double>& x) const;
+  Matrix operator*(const Matrix& dense) const;
+
+  TriangularMatrix transposed() const;
+  Matrix toDense() const;
+
+ private:
+  friend Matrix operator*(const Matrix& dense,
+                          const TriangularMatrix& triangular);
+
+  bool isStored(size_t row, size_t col) const;
+  // Stored columns of a row: [begin, end).
+  size_t rowBegin(size_t row) const;
+  size_t rowEnd(size_t row) const;
+  const double* rowData(size_t row) const;
+  double* rowData(size_t row);
+
+  size_t size_;
+  Triangle triangle_;
+  std::vector<double> values_;
+};
+
+Matrix operator*(const Matrix& dense, const TriangularMatrix& triangular);
+
+// Only the lower triangle is stored, packed by rows; set() writes both
+// mirrored entries.
+class SymmetricMatrix {
+ public:
+  explicit SymmetricMatrix(size_t size);
+  // Reads only the lower triangle of a square matrix.
+  static SymmetricMatrix fromDense(const Matrix& dense);
+
+  size_t getSize() const;
+  double get(size_t row, size_t col) const;
+  void set(size_t row, size_t col, double value);
+
+  std::vector<double> operator*(const std::vector<double>& x) const;
+  Matrix operator*(const Matrix& dense) const;
+
+  Matrix toDense() const;
+
+ private:
+  friend Matrix operator*(const Matrix& dense,
+                          const SymmetricMatrix& symmetric);
+
+  size_t index(size_t row, size_t col) const;
+
+  size_t size_;
+  std::vector<double> values_;
+};
+
+Matrix operator*(const Matrix& dense, const SymmetricMatrix& symmetric);
+
+// Entries with col - row in [-lower, upper]. Row i is stored in lower +
+// upper + 1 slots, slot lower holding the diagonal; slots that fall outside
+// the matrix stay zero.
+class BandedMatrix {
+ public:
+  BandedMatrix(size_t size, size_t lower, size_t upper);
+  // Reads only the band of a square matrix.
+  static BandedMatrix fromDense(const Matrix& dense, size_t lower,
+                                size_t upper);
+
+  size_t getSize() const;
+  size_t getLowerBandwidth() const;
+  size_t getUpperBandwidth() const;
+  double get(size_t row, size_t col) const;
+  void set(size_t row, size_t col, double value);
+
+  std::vector<double> operator*(const std::vector<double>& x) const;
+  Matrix operator*(const Matrix& dense) const;
+
+  BandedMatrix transposed() const;
+  Matrix toDense() const;
+
+ private:
+  friend Matrix operator*(const Matrix& dense, const BandedMatrix& banded);
+
+  bool isStored(size_t row, size_t col) const;
+  size_t rowBegin(size_t row) const;
+  size_t rowEnd(size_t row) const;
+  size_t index(size_t row, size_t col) const;
+
+  size_t size_;
+  size_t lower_;
+  size_t upper_;
+  std::vector<double> values_;
+};
+
+Matrix operator*(const Matrix& dense, const BandedMatrix& banded);
+
+}  // namespace task
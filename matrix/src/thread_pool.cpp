@@ -0,0 +1,123 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace task {
+
+namespace {
+
+thread_local bool inside_pool = false;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t threads) { startWorkers(threads); }
+
+ThreadPool::~ThreadPool() { stopWorkers(); }
+
+ThreadPool& ThreadPool::instance() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+size_t ThreadPool::getThreadCount() const {
+  std::lock_guard<std::mutex> lock(workers_mutex_);
+  return workers_.size() + 1;
+}
+
+void ThreadPool::setThreadCount(size_t threads) {
+  std::lock_guard<std::mutex> submit_lock(submit_mutex_);
+  std::lock_guard<std::mutex> workers_lock(workers_mutex_);
+  stopWorkers();
+  startWorkers(threads);
+}
+
+void ThreadPool::startWorkers(size_t threads) {
+  stopping_ = false;
+  for (size_t i = 1; i < threads; ++i) {
+    workers_.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+void ThreadPool::stopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void ThreadPool::runJob(Job& job) {
+  bool was_inside = inside_pool;
+  inside_pool = true;
+  size_t i;
+  while ((i = job.next.fetch_add(1)) < job.count) {
+    try {
+      (*job.task)(i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(job.error_mutex);
+      if (!job.error) job.error = std::current_exception();
+    }
+    job.done.fetch_add(1);
+  }
+  inside_pool = was_inside;
+}
+
+void ThreadPool::workerLoop() {
+  size_t seen = 0;
+  while (true) {
+    Job* job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+      if (stopping_) return;
+      seen = generation_;
+      job = job_;
+      if (job == nullptr) continue;
+      ++active_;
+    }
+    runJob(*job);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --active_;
+    }
+    finished_.notify_all();
+  }
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t)>& task) {
+  // Nested calls run inline without touching submit_mutex_, which the outer
+  // call may hold on this thread. workers_ only changes under
+  // submit_mutex_, so it is read once that is held.
+  std::unique_lock<std::mutex> submit_lock(submit_mutex_, std::defer_lock);
+  if (count <= 1 || inside_pool || !submit_lock.try_lock() ||
+      workers_.empty()) {
+    for (size_t i = 0; i < count; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  Job job;
+  job.task = &task;
+  job.count = count;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &job;
+    ++generation_;
+  }
+  wake_.notify_all();
+  runJob(job);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [&] { return job.done == count && active_ == 0; });
+    job_ = nullptr;
+  }
+  if (job.error) std::rethrow_exception(job.error);
+}
+
+}  // namespace task
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace task {
+
+// Persistent set of worker threads shared by the parallel kernels. The
+// calling thread takes part in every parallelFor, so a pool of n threads owns
+// n - 1 workers.
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t threads);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  // Sized from std::thread::hardware_concurrency() on first use.
+  static ThreadPool& instance();
+
+  size_t getThreadCount() const;
+  void setThreadCount(size_t threads);
+
+  // Calls task(i) for every i in [0, count) and returns once all calls are
+  // done. Nested calls, and calls made while another one is running, execute
+  // serially on the calling thread. The first exception thrown by a task is
+  // rethrown here.
+  void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+ private:
+  struct Job {
+    const std::function<void(size_t)>* task = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+  };
+
+  void startWorkers(size_t threads);
+  void stopWorkers();
+  void workerLoop();
+  void runJob(Job& job);
+
+  std::vector<std::thread> workers_;
+  // Held while workers_ changes size and while getThreadCount() reads it.
+  mutable std::mutex workers_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable finished_;
+  Job* job_ = nullptr;
+  size_t generation_ = 0;
+  size_t active_ = 0;
+  bool stopping_ = false;
+  std::mutex submit_mutex_;
+};
+
+}  // namespace task
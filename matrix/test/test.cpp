@@ -4,9 +4,25 @@
 #include <algorithm>
 #include <sstream>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+#include "src/blas.h"
+#include "src/factorization.h"
+#include "src/fixed_matrix.h"
 #include "src/matrix.h"
+#include "src/matrix_batch.h"
+#include "src/matrix_io.h"
+#include "src/simd.h"
+#include "src/sparse_matrix.h"
+#include "src/strassen.h"
+#include "src/structured_matrix.h"
+#include "src/thread_pool.h"
 
 
+using task::ConstMatrixView;
 using task::Matrix;
 
 
@@ -68,6 +84,30 @@ void FailWithMsg(const std::string& msg, int line) {
 const double EPS = 1e-6;
 
 
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+    size_t live_bytes = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        live_bytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        live_bytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const
+        noexcept override {
+        return this == &other;
+    }
+};
+
+
 int main(int argc, char** argv) {
 
     {
@@ -208,6 +248,1009 @@ int main(int argc, char** argv) {
     }
 
 
+    {
+        auto& pool = task::ThreadPool::instance();
+        size_t threads = pool.getThreadCount();
+        auto mat1 = RandomMatrix(300, 170);
+        auto mat2 = RandomMatrix(170, 250);
+
+        pool.setThreadCount(1);
+        Matrix serial = mat1 * mat2;
+        Matrix serial_wide = mat2.transposed() * mat1.transposed();
+
+        pool.setThreadCount(4);
+        ASSERT_TRUE_MSG(pool.getThreadCount() == 4, "setThreadCount()")
+        ASSERT_TRUE_MSG(mat1 * mat2 == serial, "Parallel operator *")
+        ASSERT_TRUE_MSG(mat2.transposed() * mat1.transposed() == serial_wide,
+                        "Parallel operator *")
+
+        std::thread resizer([&pool] {
+            for (size_t i = 0; i < 20; ++i) {
+                pool.setThreadCount(2 + i % 3);
+            }
+        });
+        bool ok = true;
+        for (size_t i = 0; i < 10; ++i) {
+            ok = ok && mat1 * mat2 == serial;
+        }
+        resizer.join();
+        ASSERT_TRUE_MSG(ok, "operator * during setThreadCount()")
+
+        pool.setThreadCount(threads);
+    }
+
+
+    REPEAT(10)
+    {
+        size_t n = _iter == 0 ? 130 : RandomUInt(1, 100);
+        auto mat = RandomMatrix(n, n);
+        for (size_t i = 0; i < n; ++i) {
+            mat[i][i] += 10. * n;
+        }
+        auto rhs = RandomMatrix(n, RandomUInt(1, 10));
+        std::vector<double> vec = RandomMatrix(n, 1).getColumn(0);
+
+        task::LU lu(mat);
+        ASSERT_TRUE_MSG(!lu.isSingular(), "LU")
+        ASSERT_TRUE_MSG(mat * lu.solve(rhs) == rhs, "LU solve()")
+        ASSERT_TRUE_MSG(mat * lu.inverse() == Matrix(n, n), "LU inverse()")
+
+        Matrix column(n, 1);
+        std::vector<double> solution = lu.solve(vec);
+        for (size_t i = 0; i < n; ++i) {
+            column[i][0] = solution[i];
+        }
+        Matrix product = mat * column;
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_TRUE_MSG(fabs(product[i][0] - vec[i]) < EPS, "LU solve()")
+        }
+    }
+
+    REPEAT(10)
+    {
+        // det(P L U) = +-prod(diag(U)) for a unit lower L.
+        size_t n = _iter == 0 ? 130 : RandomUInt(2, 100);
+        Matrix lower(n, n), upper(n, n);
+        double expected = 1.;
+        for (size_t i = 0; i < n; ++i) {
+            upper[i][i] = 1. + RandomDouble() / 20.;
+            expected *= upper[i][i];
+            for (size_t j = 0; j < i; ++j) {
+                lower[i][j] = RandomDouble() / 100.;
+                upper[j][i] = RandomDouble() / 100.;
+            }
+        }
+        Matrix mat = lower * upper;
+        ASSERT_TRUE_MSG(fabs(mat.det() - expected) < EPS * fabs(expected),
+                        "Determinant")
+        ASSERT_TRUE_MSG(fabs(task::LU(mat).det() - expected) <
+                        EPS * fabs(expected), "LU det()")
+
+        size_t row = RandomUInt(0, n - 2);
+        std::swap_ranges(mat[row], mat[row] + n, mat[n - 1]);
+        ASSERT_TRUE_MSG(fabs(mat.det() + expected) < EPS * fabs(expected),
+                        "Determinant")
+    }
+
+    {
+        // Large enough for the blocked path, small enough for float range.
+        size_t n = 90;
+        Matrix mat = RandomMatrix(n, n) * 0.01;
+        task::BasicMatrix<float> floats(n, n);
+        task::BasicMatrix<std::complex<double>> complexes(n, n);
+        for (size_t i = 0; i < n; ++i) {
+            mat[i][i] += 1.;
+            for (size_t j = 0; j < n; ++j) {
+                floats[i][j] = static_cast<float>(mat[i][j]);
+                complexes[i][j] = mat[i][j];
+            }
+        }
+        double det = mat.det();
+        ASSERT_TRUE_MSG(fabs(floats.det() - det) < 1e-3 * fabs(det),
+                        "Float determinant")
+        ASSERT_TRUE_MSG(std::abs(complexes.det() - det) < EPS * fabs(det),
+                        "Complex determinant")
+
+        task::BasicMatrix<std::complex<double>> small(2, 2);
+        small[0][0] = {1., 1.};
+        small[0][1] = 2.;
+        small[1][0] = 3.;
+        small[1][1] = {4., -1.};
+        ASSERT_TRUE_MSG(std::abs(small.det() - std::complex<double>(-1., 3.)) <
+                        EPS, "Complex determinant")
+    }
+
+    {
+        auto mat = RandomMatrix(5, 5);
+        for (size_t i = 0; i < 5; ++i) {
+            mat[i][2] = 0.;
+        }
+        task::LU lu(mat);
+        ASSERT_TRUE_MSG(lu.isSingular(), "LU isSingular()")
+        ASSERT_TRUE_MSG(lu.det() == 0. && mat.det() == 0., "LU det()")
+        ASSERT_EXCEPTION_MSG(lu.solve(Matrix(5, 1)),
+                             task::SingularMatrixException, "LU solve()")
+        ASSERT_EXCEPTION_MSG(lu.inverse(), task::SingularMatrixException,
+                             "LU inverse()")
+        ASSERT_EXCEPTION_MSG(task::LU(RandomMatrix(3, 4)),
+                             task::SizeMismatchException, "LU")
+    }
+
+    REPEAT(10)
+    {
+        size_t n = RandomUInt(1, 100);
+        Matrix base = RandomMatrix(n, n) * 0.1;
+        Matrix mat = base * base.transposed();
+        for (size_t i = 0; i < n; ++i) {
+            mat[i][i] += n;
+        }
+        auto rhs = RandomMatrix(n, RandomUInt(1, 10));
+
+        task::Cholesky cholesky(mat);
+        const Matrix& lower = cholesky.getL();
+        ASSERT_TRUE_MSG(lower * lower.transposed() == mat, "Cholesky getL()")
+        ASSERT_TRUE_MSG(mat * cholesky.solve(rhs) == rhs, "Cholesky solve()")
+        ASSERT_TRUE_MSG(mat * cholesky.inverse() == Matrix(n, n),
+                        "Cholesky inverse()")
+        double det = task::LU(mat).det();
+        ASSERT_TRUE_MSG(fabs(cholesky.det() - det) < EPS * fabs(det),
+                        "Cholesky det()")
+
+        mat[n - 1][n - 1] = -1.;
+        ASSERT_EXCEPTION_MSG(task::Cholesky{mat},
+                             task::NotPositiveDefiniteException, "Cholesky")
+    }
+
+
+    {
+        namespace simd = task::simd;
+        simd::Level previous = simd::getLevel();
+        simd::Level supported = simd::getSupportedLevel();
+        // Compares every kernel with the portable loops; no length is a
+        // multiple of a vector width, so the tails run too.
+        auto checkKernels = [](auto zero, double eps) {
+            using T = decltype(zero);
+            for (size_t n : {1, 3, 7, 19, 37, 67}) {
+                std::vector<T> a(n), b(n), out(n), expected(n);
+                for (size_t i = 0; i < n; ++i) {
+                    a[i] = T(RandomDouble());
+                    b[i] = T(RandomDouble());
+                }
+                T alpha = T(RandomDouble());
+                bool ok = true;
+
+                simd::add(n, a.data(), b.data(), out.data());
+                simd::portable::add(n, a.data(), b.data(), expected.data());
+                ok = ok && out == expected;
+                simd::subtract(n, a.data(), b.data(), out.data());
+                simd::portable::subtract(n, a.data(), b.data(),
+                                         expected.data());
+                ok = ok && out == expected;
+                simd::scale(n, alpha, a.data(), out.data());
+                simd::portable::scale(n, alpha, a.data(), expected.data());
+                ok = ok && out == expected;
+                simd::negate(n, a.data(), out.data());
+                simd::portable::negate(n, a.data(), expected.data());
+                ok = ok && out == expected;
+
+                out = b;
+                expected = b;
+                simd::axpy(n, alpha, a.data(), out.data());
+                simd::portable::axpy(n, alpha, a.data(), expected.data());
+                ok = ok && simd::portable::allClose(n, out.data(),
+                                                    expected.data(), eps);
+                ok = ok && std::abs(simd::stridedSum(n / 2 + 1, a.data(), 2) -
+                                    simd::portable::stridedSum(
+                                        n / 2 + 1, a.data(), 2)) <= eps;
+
+                ok = ok && simd::allClose(n, a.data(), a.data(), 0.);
+                expected = a;
+                expected[n - 1] += T(1);
+                ok = ok && !simd::allClose(n, a.data(), expected.data(), .5);
+                ok = ok && simd::allClose(n, a.data(), expected.data(), 1.5);
+                expected = a;
+                expected[0] -= T(1);
+                ok = ok && !simd::allClose(n, a.data(), expected.data(), .5);
+                if (!ok) return false;
+            }
+            return true;
+        };
+        for (int level = 0; level <= static_cast<int>(supported); ++level) {
+            simd::setLevel(static_cast<simd::Level>(level));
+            ASSERT_TRUE_MSG(checkKernels(0., 1e-9), "simd kernels (double)")
+            ASSERT_TRUE_MSG(checkKernels(0.f, 1e-3), "simd kernels (float)")
+
+            double doubles[19] = {};
+            doubles[1] = -0.;
+            doubles[2] = 1.5;
+            simd::negate(19, doubles, doubles);
+            float floats[35] = {};
+            simd::negate(35, floats, floats);
+
+            for (size_t i = 0; i < 19; ++i) {
+                ASSERT_TRUE_MSG(std::signbit(doubles[i]) == (i != 1),
+                                "simd::negate()")
+            }
+            for (float value : floats) {
+                ASSERT_TRUE_MSG(std::signbit(value), "simd::negate()")
+            }
+            ASSERT_TRUE_MSG(doubles[2] == -1.5, "simd::negate()")
+        }
+        simd::setLevel(previous);
+        ASSERT_TRUE_MSG(simd::getLevel() == previous, "simd::setLevel()")
+    }
+
+
+    {
+        auto mat = RandomMatrix(6, 7);
+        const Matrix copy = mat;
+
+        auto row = RandomMatrix(1, 7);
+        mat.rowView(2) = row;
+        mat.columnView(3) *= 2.;
+        auto block = RandomMatrix(3, 4);
+        mat.blockView(1, 1, 3, 4) += block;
+        mat.blockView(4, 5, 2, 2).set(1, 0, 100.);
+        for (size_t i = 0; i < 6; ++i) {
+            for (size_t j = 0; j < 7; ++j) {
+                double expected = i == 2 ? row[0][j] : copy[i][j];
+                if (j == 3) expected *= 2.;
+                if (i >= 1 && i < 4 && j >= 1 && j < 5) {
+                    expected += block[i - 1][j - 1];
+                }
+                if (i == 5 && j == 5) expected = 100.;
+                ASSERT_TRUE_MSG(fabs(mat[i][j] - expected) < EPS,
+                                "Writes through views")
+            }
+        }
+        ASSERT_EXCEPTION_MSG(mat.blockView(4, 5, 3, 2),
+                             task::OutOfBoundsException, "blockView()")
+        ASSERT_EXCEPTION_MSG(mat.columnView(3).get(6, 0),
+                             task::OutOfBoundsException, "columnView()")
+
+        Matrix sum = copy.blockView(0, 0, 2, 3) - 2. * mat.blockView(1, 2, 2, 3);
+        ASSERT_TRUE_MSG(sum.getRowSize() == 2 && sum.getColSize() == 3,
+                        "Views in expressions")
+        for (size_t i = 0; i < 2; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                ASSERT_TRUE_MSG(fabs(sum[i][j] - copy[i][j] +
+                                     2. * mat[i + 1][j + 2]) < EPS,
+                                "Views in expressions")
+            }
+        }
+        ASSERT_TRUE_MSG(copy.columnView(4) == Matrix(copy.columnView(4)),
+                        "Views in expressions")
+
+        auto other = RandomMatrix(5, 6);
+        Matrix product = ConstMatrixView(copy).transposed() *
+                         other.blockView(1, 0, 4, 6).transposed();
+        ASSERT_TRUE_MSG(product == copy.transposed() *
+                                       Matrix(other.blockView(1, 0, 4, 6))
+                                           .transposed(),
+                        "Products of views")
+        ASSERT_TRUE_MSG(copy.columnView(1) * copy.rowView(1) ==
+                            Matrix(copy.columnView(1)) *
+                                Matrix(copy.rowView(1)),
+                        "Products of views")
+    }
+
+    for (size_t n : {3, 5, 40}) {
+        auto mat = RandomMatrix(n, n);
+        Matrix expected = mat.transposed();
+        mat = ConstMatrixView(mat).transposed();
+        ASSERT_TRUE_MSG(mat == expected, "Assigning a view of the matrix")
+
+        expected = 2. * mat + mat.transposed();
+        mat = mat * 2. + ConstMatrixView(mat).transposed();
+        ASSERT_TRUE_MSG(mat == expected, "Assigning a view of the matrix")
+
+        expected = mat + mat.transposed();
+        mat += ConstMatrixView(mat).transposed();
+        ASSERT_TRUE_MSG(mat == expected, "Adding a view of the matrix")
+
+        expected = Matrix(mat.blockView(1, 0, n - 1, 2));
+        mat = mat.blockView(1, 0, n - 1, 2);
+        ASSERT_TRUE_MSG(mat == expected, "Assigning a view of the matrix")
+
+        expected = mat.transposed();
+        mat = ConstMatrixView(mat).transposed();
+        ASSERT_TRUE_MSG(mat == expected, "Assigning a view of the matrix")
+    }
+
+
+    {
+        auto mat1 = RandomMatrix(4, 6);
+        auto mat2 = RandomMatrix(6, 5);
+        auto mat3 = RandomMatrix(4, 5);
+        Matrix expected = 2. * (mat1 * mat2) + 3. * mat3;
+
+        Matrix res = mat3;
+        task::gemm(2., mat1, mat2, 3., res);
+        ASSERT_TRUE_MSG(res == expected, "gemm()")
+
+        Matrix res_t = mat3.transposed();
+        task::gemm(2., mat1, mat2, 3., task::MatrixView(res_t).transposed());
+        ASSERT_TRUE_MSG(res_t.transposed() == expected, "Strided gemm()")
+
+        Matrix square = RandomMatrix(5, 5);
+        Matrix nans(5, 5);
+        nans[0][0] = NAN;
+        nans[4][1] = INFINITY;
+        task::gemm(1., square, Matrix(5, 5), 0., nans);
+        ASSERT_TRUE_MSG(nans == square, "gemm() with beta == 0")
+        nans[0][0] = NAN;
+        nans[4][1] = INFINITY;
+        task::gemm(1., square, Matrix(5, 5), 0.,
+                   task::MatrixView(nans).transposed());
+        ASSERT_TRUE_MSG(nans == square.transposed(), "gemm() with beta == 0")
+
+        Matrix aliased = square;
+        task::gemm(1., aliased, aliased, 1., aliased);
+        ASSERT_TRUE_MSG(aliased == square * square + square,
+                        "gemm() with C as an operand")
+    }
+
+
+    {
+        const std::string path = "test_matrix.bin";
+        auto mat = RandomMatrix(37, 23);
+        task::saveBinary(path, mat);
+        ASSERT_TRUE_MSG(task::loadBinary(path) == mat, "Binary round trip")
+        {
+            task::MappedMatrix mapped(path);
+            ASSERT_TRUE_MSG(mapped.getRowSize() == 37 &&
+                            mapped.getColSize() == 23, "MappedMatrix")
+            ASSERT_TRUE_MSG(mapped == mat, "MappedMatrix")
+            ASSERT_TRUE_MSG(mapped.get(36, 22) == mat[36][22], "MappedMatrix")
+            ASSERT_EXCEPTION_MSG(mapped.get(37, 0),
+                                 task::OutOfBoundsException, "MappedMatrix")
+            ASSERT_TRUE_MSG(mapped * mat.transposed() ==
+                            mat * mat.transposed(), "MappedMatrix")
+            auto other = RandomMatrix(37, 23);
+            Matrix sum(2, 2);
+            sum = mapped + other;
+            ASSERT_TRUE_MSG(sum == mat + other, "MappedMatrix expression")
+            sum = other;
+            sum += mapped;
+            sum -= mapped * 2.;
+            ASSERT_TRUE_MSG(sum == other - mat, "MappedMatrix expression")
+        }
+        ASSERT_EXCEPTION_MSG(task::loadBinary<float>(path),
+                             task::FileFormatException, "Binary data type")
+        ASSERT_EXCEPTION_MSG(task::loadBinary<int64_t>(path),
+                             task::FileFormatException, "Binary data type")
+
+        task::BasicMatrix<float> floats(3, 4);
+        floats[2][1] = 0.25f;
+        task::saveBinary(path, floats);
+        ASSERT_TRUE_MSG(task::loadBinary<float>(path) == floats,
+                        "Binary round trip")
+        ASSERT_EXCEPTION_MSG(task::loadBinary(path),
+                             task::FileFormatException, "Binary data type")
+        ASSERT_EXCEPTION_MSG(task::MappedMatrix{path},
+                             task::FileFormatException, "Binary data type")
+
+        std::stringstream stream;
+        task::writeBinary(stream, mat);
+        std::string bytes = stream.str();
+        for (size_t size : {size_t(0), size_t(10), sizeof(task::BinaryHeader),
+                            bytes.size() - 1}) {
+            std::istringstream input(bytes.substr(0, size));
+            ASSERT_EXCEPTION_MSG(task::readBinary(input),
+                                 task::FileFormatException, "Truncated file")
+            {
+                std::ofstream output(path, std::ios::binary);
+                output << bytes.substr(0, size);
+            }
+            ASSERT_EXCEPTION_MSG(task::loadBinary(path),
+                                 task::FileFormatException, "Truncated file")
+            ASSERT_EXCEPTION_MSG(task::MappedMatrix{path},
+                                 task::FileFormatException, "Truncated file")
+        }
+        std::remove(path.c_str());
+        ASSERT_EXCEPTION_MSG(task::loadBinary(path), task::IoException,
+                             "Missing file")
+    }
+
+
+    {
+        auto mat1 = RandomMatrix(30, 20);
+        auto mat2 = RandomMatrix(1, 3);
+        std::stringstream stream;
+        {
+            task::MatrixWriter writer(stream);
+            writer.write(mat1);
+            writer.write(2.5);
+            writer.write(mat2);
+        }
+        Matrix read = RandomMatrix(40, 40);
+        double scalar = 0.;
+        task::MatrixReader reader(stream, 16);
+        ASSERT_TRUE_MSG(reader.read(read) && read == mat1, "MatrixReader")
+        ASSERT_TRUE_MSG(reader.read(scalar) && scalar == 2.5, "MatrixReader")
+        ASSERT_TRUE_MSG(reader.read(read) && read == mat2, "MatrixReader")
+        ASSERT_TRUE_MSG(!reader.read(read), "MatrixReader")
+
+        std::string one = "1." + std::string(700, '0');
+        std::string text = "1 3\n" + one + " " + std::string(1500, '0') +
+                           "42 -" + one + "e1\n";
+        std::istringstream input(text);
+        ASSERT_TRUE_MSG(input >> read, "Long numbers")
+        ASSERT_TRUE_MSG(read[0][0] == 1. && read[0][1] == 42. &&
+                        read[0][2] == -10., "Long numbers")
+        std::istringstream reader_input(text);
+        task::MatrixReader long_reader(reader_input, 16);
+        read = Matrix();
+        ASSERT_TRUE_MSG(long_reader.read(read), "Long numbers")
+        ASSERT_TRUE_MSG(read[0][0] == 1. && read[0][1] == 42. &&
+                        read[0][2] == -10., "Long numbers")
+
+        Matrix huge(2, 2);
+        huge[0][1] = 1e300;
+        huge[1][0] = -1.5e299;
+        std::stringstream fixed;
+        fixed << std::fixed;
+        fixed.precision(300);
+        fixed << "2 2\n" << huge;
+        ASSERT_TRUE_MSG(fixed >> read, "Long numbers")
+        ASSERT_TRUE_MSG(read[0][1] == 1e300 && read[1][0] == -1.5e299 &&
+                        read[1][1] == 1., "Long numbers")
+    }
+
+
+    REPEAT(10)
+    {
+        size_t rows = RandomUInt(1, 60), cols = RandomUInt(1, 60);
+        auto dense = RandomMatrix(rows, cols);
+        size_t non_zeros = 0;
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                if (RandomUInt(3) != 0) {
+                    dense[i][j] = 0.;
+                } else {
+                    ++non_zeros;
+                }
+            }
+        }
+        auto csr = task::CsrMatrix::fromDense(dense);
+        auto csc = task::CscMatrix::fromDense(dense);
+        ASSERT_TRUE_MSG(csr.getNonZeroCount() == non_zeros &&
+                        csc.getNonZeroCount() == non_zeros, "fromDense()")
+        ASSERT_TRUE_MSG(csr.toDense() == dense && csc.toDense() == dense,
+                        "Sparse round trip")
+        ASSERT_TRUE_MSG(csr.toCsc().toDense() == dense &&
+                        csc.toCsr().toDense() == dense, "CSR / CSC conversion")
+        ASSERT_TRUE_MSG(csr.transposed().toDense() == dense.transposed() &&
+                        csc.transposed().toDense() == dense.transposed(),
+                        "Sparse transposed()")
+        ASSERT_TRUE_MSG(task::CsrMatrix::fromDense(dense, 10.)
+                            .getNonZeroCount() == 0, "fromDense() tolerance")
+
+        auto right = RandomMatrix(cols, RandomUInt(1, 20));
+        auto left = RandomMatrix(RandomUInt(1, 20), rows);
+        ASSERT_TRUE_MSG(csr * right == dense * right, "Sparse * dense")
+        ASSERT_TRUE_MSG(left * csc == left * dense, "Dense * sparse")
+        std::vector<double> vec = right.getColumn(0);
+        std::vector<double> csr_product = csr * vec;
+        std::vector<double> csc_product = csc * vec;
+        Matrix expected = dense * right.blockView(0, 0, cols, 1);
+        for (size_t i = 0; i < rows; ++i) {
+            ASSERT_TRUE_MSG(fabs(csr_product[i] - expected[i][0]) < EPS &&
+                            fabs(csc_product[i] - expected[i][0]) < EPS,
+                            "Sparse * vector")
+        }
+
+        auto other = task::CsrMatrix::fromDense(RandomMatrix(rows, cols));
+        ASSERT_TRUE_MSG((csr + other).toDense() == dense + other.toDense(),
+                        "Sparse operator +")
+        auto negated = task::CsrMatrix::fromDense(-dense);
+        ASSERT_TRUE_MSG((csr + negated).getNonZeroCount() == 0,
+                        "Sparse operator + drops zeros")
+        if (rows != cols) {
+            ASSERT_EXCEPTION_MSG(csr + csr.transposed(),
+                                 task::SizeMismatchException,
+                                 "Sparse operator +")
+        }
+    }
+
+    {
+        std::vector<task::Triplet> triplets = {
+            {2, 0, 1.}, {0, 1, 2.}, {1, 1, 0.}, {0, 1, 3.}, {2, 0, -1.},
+            {1, 2, 4.}};
+        task::CsrMatrix csr(3, 3, triplets);
+        task::CscMatrix csc(3, 3, triplets);
+        ASSERT_TRUE_MSG(csr.getNonZeroCount() == 2 &&
+                        csc.getNonZeroCount() == 2, "Sparse triplets")
+        ASSERT_TRUE_MSG(csr.get(0, 1) == 5. && csc.get(0, 1) == 5. &&
+                        csr.get(1, 2) == 4. && csr.get(2, 0) == 0.,
+                        "Sparse triplets")
+        ASSERT_EXCEPTION_MSG(csr.get(3, 0), task::OutOfBoundsException,
+                             "Sparse get()")
+        triplets.push_back({0, 3, 1.});
+        ASSERT_EXCEPTION_MSG(task::CsrMatrix(3, 3, triplets),
+                             task::OutOfBoundsException, "Sparse triplets")
+    }
+
+
+    {
+        auto mat1 = RandomMatrix(65, 68);
+        auto mat2 = RandomMatrix(68, 64);
+        ASSERT_TRUE_MSG(task::strassenMultiply(mat1, mat2, 16) == mat1 * mat2,
+                        "strassenMultiply()")
+        ASSERT_TRUE_MSG(task::strassenMultiply(mat2.transposed(),
+                                               mat1.transposed(), 16) ==
+                            mat2.transposed() * mat1.transposed(),
+                        "strassenMultiply()")
+        ASSERT_TRUE_MSG(task::strassenMultiply(mat1, mat2) == mat1 * mat2,
+                        "strassenMultiply()")
+
+        auto square = RandomMatrix(97, 97);
+        ASSERT_TRUE_MSG(task::strassenMultiply(ConstMatrixView(square)
+                                                   .transposed(),
+                                               square.blockView(0, 0, 97, 97),
+                                               8) ==
+                            square.transposed() * square,
+                        "strassenMultiply() of views")
+        ASSERT_EXCEPTION_MSG(task::strassenMultiply(mat1, mat1, 16),
+                             task::SizeMismatchException,
+                             "strassenMultiply()")
+    }
+
+
+    {
+        CountingResource counting;
+        {
+            task::MatrixResourceScope scope(&counting);
+            auto mat1 = RandomMatrix(20, 20);
+            Matrix mat2 = mat1 * mat1;
+            Matrix small(2, 2);
+            ASSERT_TRUE_MSG(mat1.getResource() == &counting &&
+                            mat2.getResource() == &counting &&
+                            small.getResource() == &counting,
+                            "MatrixResourceScope")
+            ASSERT_TRUE_MSG(counting.allocations >= 2 &&
+                            counting.live_bytes > 0, "MatrixResourceScope")
+        }
+        ASSERT_TRUE_MSG(counting.live_bytes == 0, "MatrixResourceScope")
+        ASSERT_TRUE_MSG(task::getMatrixResource() ==
+                        std::pmr::get_default_resource(),
+                        "MatrixResourceScope")
+
+        Matrix out(20, 20);
+        Matrix moved(20, 20);
+        Matrix small(2, 2);
+        Matrix expected;
+        {
+            std::pmr::monotonic_buffer_resource arena;
+            task::MatrixResourceScope scope(&arena);
+            auto mat1 = RandomMatrix(20, 20);
+            auto mat2 = RandomMatrix(20, 20);
+            out = mat1 * mat2;
+            Matrix product = mat1 * mat2;
+            ASSERT_TRUE_MSG(product.getResource() == &arena,
+                            "MatrixResourceScope")
+            moved = std::move(product);
+            small = RandomMatrix(2, 2);
+            expected = out;
+        }
+        ASSERT_TRUE_MSG(out.getResource() == std::pmr::get_default_resource()
+                        && moved.getResource() ==
+                               std::pmr::get_default_resource(),
+                        "Matrix escaping a MatrixResourceScope")
+        ASSERT_TRUE_MSG(moved == expected,
+                        "Matrix escaping a MatrixResourceScope")
+        out[0][0] += 1.;
+        expected[0][0] += 1.;
+        ASSERT_TRUE_MSG(out == expected,
+                        "Matrix escaping a MatrixResourceScope")
+        small.resize(20, 20);
+        small[19][19] = 1.;
+        ASSERT_TRUE_MSG(small.getResource() ==
+                        std::pmr::get_default_resource(),
+                        "Matrix escaping a MatrixResourceScope")
+    }
+
+
+#ifdef MATRIX_INSTRUMENTATION
+    {
+        auto mat1 = RandomMatrix(20, 20);
+        Matrix small(2, 2);
+        task::resetOperationStats();
+        Matrix sum = mat1 + mat1;
+        Matrix product = mat1 * mat1;
+        small = mat1 + mat1;
+        auto stats = task::getOperationStats();
+        auto evaluate = stats[size_t(task::Operation::kEvaluate)];
+        auto multiply = stats[size_t(task::Operation::kMultiply)];
+        ASSERT_TRUE_MSG(evaluate.calls == 2 && evaluate.temporaries == 1,
+                        "Instrumentation temporaries")
+        ASSERT_TRUE_MSG(multiply.calls == 1 && multiply.temporaries == 1,
+                        "Instrumentation temporaries")
+        std::ostringstream dump;
+        task::dumpOperationStats(dump);
+        ASSERT_TRUE_MSG(dump.str().find("temporaries=1") != std::string::npos,
+                        "dumpOperationStats()")
+
+        task::resetOperationStats();
+        Matrix dense = task::DiagonalMatrix(20).toDense();
+        stats = task::getOperationStats();
+        ASSERT_TRUE_MSG(stats[size_t(task::Operation::kResize)].calls == 0 &&
+                        stats[size_t(task::Operation::kConstruct)].calls == 1,
+                        "Structured toDense() instrumentation")
+    }
+#endif
+
+
+#ifdef MATRIX_COPY_ON_WRITE
+    {
+        auto mat1 = RandomMatrix(20, 20);
+        const Matrix& source = mat1;
+        Matrix copy = mat1;
+        Matrix assigned(3, 3);
+        assigned = mat1;
+        const Matrix& shared = copy;
+        ASSERT_TRUE_MSG(shared[0] == source[0] &&
+                        static_cast<const Matrix&>(assigned)[0] == source[0],
+                        "Copy-on-write copies share storage")
+        double value = source[0][0];
+        copy[0][0] += 1.;
+        ASSERT_TRUE_MSG(shared[0] != source[0] && source[0][0] == value &&
+                        shared[0][0] == value + 1.,
+                        "Copy-on-write write detaches")
+        double diagonal = source[1][1];
+        assigned.set(1, 1, diagonal + 1.);
+        ASSERT_TRUE_MSG(static_cast<const Matrix&>(assigned)[0] !=
+                        source[0] && source[1][1] == diagonal &&
+                        assigned.get(1, 1) == diagonal + 1.,
+                        "Copy-on-write set() detaches")
+
+        Matrix small = RandomMatrix(2, 2);
+        Matrix small_copy = small;
+        ASSERT_TRUE_MSG(static_cast<const Matrix&>(small_copy)[0] !=
+                        static_cast<const Matrix&>(small)[0],
+                        "Inline matrices are copied")
+    }
+#endif
+
+#ifdef MATRIX_INSTRUMENTATION
+    {
+        auto mat1 = RandomMatrix(20, 20);
+        task::resetOperationStats();
+        Matrix power = mat1.pow(13);
+        auto pow = task::getOperationStats()[size_t(task::Operation::kPow)];
+        ASSERT_TRUE_MSG(pow.allocations == 3,
+                        "pow() allocates only its result and work buffers")
+    }
+#endif
+
+
+    {
+        auto mat = RandomMatrix(2, 2);
+        auto expected = mat;
+        mat.resize(3, 5);
+        bool ok = mat[0][0] == expected[0][0] && mat[0][1] == expected[0][1]
+                  && mat[0][2] == expected[1][0] &&
+                  mat[0][3] == expected[1][1];
+        for (size_t i = 4; i < 15; ++i) {
+            ok = ok && mat[i / 5][i % 5] == 0.;
+        }
+        ASSERT_TRUE_MSG(ok, "resize() within the inline buffer")
+    }
+
+
+    {
+        const size_t n = 30;
+        auto dense = RandomMatrix(n, n);
+        for (size_t i = 0; i < n; ++i) {
+            dense[i][i] = 20. + i;
+        }
+        auto right = RandomMatrix(n, 7);
+        auto left = RandomMatrix(7, n);
+        auto relativeClose = [](double a, double b) {
+            return std::abs(a - b) <= EPS * std::max(1., std::abs(b));
+        };
+
+        auto diagonal = task::DiagonalMatrix::fromDense(dense);
+        auto diagonal_dense = diagonal.toDense();
+        ASSERT_TRUE_MSG(diagonal * right == diagonal_dense * right &&
+                        left * diagonal == left * diagonal_dense,
+                        "DiagonalMatrix products")
+        ASSERT_TRUE_MSG(diagonal * diagonal.solve(right) == right,
+                        "DiagonalMatrix solve()")
+        ASSERT_TRUE_MSG(relativeClose(diagonal.det(), diagonal_dense.det()),
+                        "DiagonalMatrix det()")
+        ASSERT_TRUE_MSG(diagonal.get(0, 1) == 0., "DiagonalMatrix get()")
+        ASSERT_EXCEPTION_MSG(diagonal.set(n, 1.), task::OutOfBoundsException,
+                             "DiagonalMatrix set()")
+        diagonal.set(0, 0.);
+        ASSERT_EXCEPTION_MSG(diagonal.solve(right),
+                             task::SingularMatrixException,
+                             "DiagonalMatrix solve()")
+
+        for (auto triangle : {task::Triangle::kLower, task::Triangle::kUpper}) {
+            auto triangular = task::TriangularMatrix::fromDense(dense,
+                                                                triangle);
+            auto triangular_dense = triangular.toDense();
+            ASSERT_TRUE_MSG(triangular * right == triangular_dense * right &&
+                            left * triangular == left * triangular_dense,
+                            "TriangularMatrix products")
+            ASSERT_TRUE_MSG(triangular * triangular.solve(right) == right,
+                            "TriangularMatrix solve()")
+            std::vector<double> b(n);
+            for (size_t i = 0; i < n; ++i) {
+                b[i] = RandomDouble();
+            }
+            std::vector<double> x = triangular.solve(b);
+            std::vector<double> residual = triangular * x;
+            bool ok = true;
+            for (size_t i = 0; i < n; ++i) {
+                ok = ok && std::abs(residual[i] - b[i]) < EPS;
+            }
+            ASSERT_TRUE_MSG(ok, "TriangularMatrix solve()")
+            ASSERT_TRUE_MSG(relativeClose(triangular.det(),
+                                          triangular_dense.det()),
+                            "TriangularMatrix det()")
+            ASSERT_TRUE_MSG(triangular.transposed().toDense() ==
+                            triangular_dense.transposed(),
+                            "TriangularMatrix transposed()")
+            bool lower = triangle == task::Triangle::kLower;
+            ASSERT_TRUE_MSG(triangular.get(lower ? 0 : 1, lower ? 1 : 0) == 0.,
+                            "TriangularMatrix get()")
+            ASSERT_EXCEPTION_MSG(triangular.set(lower ? 0 : 1, lower ? 1 : 0,
+                                                1.),
+                                 task::OutOfBoundsException,
+                                 "TriangularMatrix set()")
+            triangular.set(n - 1, n - 1, 0.);
+            ASSERT_EXCEPTION_MSG(triangular.solve(right),
+                                 task::SingularMatrixException,
+                                 "TriangularMatrix solve()")
+        }
+
+        auto symmetric = task::SymmetricMatrix::fromDense(dense);
+        auto symmetric_dense = symmetric.toDense();
+        ASSERT_TRUE_MSG(symmetric_dense == symmetric_dense.transposed() &&
+                        symmetric.get(n - 1, 0) == dense[n - 1][0],
+                        "SymmetricMatrix fromDense()")
+        ASSERT_TRUE_MSG(symmetric * right == symmetric_dense * right &&
+                        left * symmetric == left * symmetric_dense,
+                        "SymmetricMatrix products")
+        symmetric.set(0, 1, 5.);
+        ASSERT_TRUE_MSG(symmetric.get(1, 0) == 5., "SymmetricMatrix set()")
+        ASSERT_EXCEPTION_MSG(symmetric.set(0, n, 1.),
+                             task::OutOfBoundsException,
+                             "SymmetricMatrix set()")
+
+        auto banded = task::BandedMatrix::fromDense(dense, 2, 3);
+        auto banded_dense = banded.toDense();
+        ASSERT_TRUE_MSG(banded_dense[5][3] == dense[5][3] &&
+                        banded_dense[5][2] == 0. &&
+                        banded_dense[5][8] == dense[5][8] &&
+                        banded_dense[5][9] == 0.,
+                        "BandedMatrix fromDense()")
+        ASSERT_TRUE_MSG(banded * right == banded_dense * right &&
+                        left * banded == left * banded_dense,
+                        "BandedMatrix products")
+        ASSERT_TRUE_MSG(banded.transposed().toDense() ==
+                        banded_dense.transposed(),
+                        "BandedMatrix transposed()")
+        banded.set(n - 1, n - 3, 1.);
+        ASSERT_EXCEPTION_MSG(banded.set(5, 2, 1.),
+                             task::OutOfBoundsException,
+                             "BandedMatrix set()")
+        ASSERT_EXCEPTION_MSG(banded.set(5, 9, 1.),
+                             task::OutOfBoundsException,
+                             "BandedMatrix set()")
+
+        ASSERT_EXCEPTION_MSG(diagonal * left, task::SizeMismatchException,
+                             "Structured product")
+        ASSERT_EXCEPTION_MSG(right * banded, task::SizeMismatchException,
+                             "Structured product")
+    }
+
+
+    {
+        for (size_t n : {3, 20}) {
+            Matrix mat = RandomMatrix(n, n) * (0.05 / std::sqrt(double(n)));
+            ASSERT_TRUE_MSG(mat.pow(0) == Matrix(n, n), "pow(0)")
+            ASSERT_TRUE_MSG(mat.pow(1) == mat, "pow(1)")
+            Matrix expected = mat;
+            for (size_t power = 2; power <= 7; ++power) {
+                expected = expected * mat;
+                ASSERT_TRUE_MSG(mat.pow(power) == expected, "pow()")
+            }
+        }
+        ASSERT_EXCEPTION_MSG(RandomMatrix(3, 4).pow(2),
+                             task::SizeMismatchException, "pow()")
+    }
+
+
+    {
+        using task::FixedMatrix;
+        constexpr FixedMatrix<2, 2> a2({4., 7., 2., 6.});
+        static_assert(a2.det() == 10., "FixedMatrix 2x2 det()");
+        static_assert(a2.inverse() == FixedMatrix<2, 2>({.6, -.7, -.2, .4}),
+                      "FixedMatrix 2x2 inverse()");
+        static_assert(a2 * a2.inverse() == FixedMatrix<2, 2>(),
+                      "FixedMatrix 2x2 product");
+        static_assert(a2.trace() == 10., "FixedMatrix trace()");
+
+        constexpr FixedMatrix<3, 3, int64_t> a3({2, 0, 1, 1, 3, 2, 1, 1, 2});
+        static_assert(a3.det() == 6, "FixedMatrix 3x3 det()");
+        static_assert(a3.transposed().det() == 6 && a3.trace() == 7,
+                      "FixedMatrix 3x3 transposed()");
+        static_assert(a3.transposed()[0][1] == 1 && a3.transposed()[2][0] == 1,
+                      "FixedMatrix 3x3 transposed()");
+        static_assert(a3.adjugate() * a3 ==
+                          FixedMatrix<3, 3, int64_t>() * int64_t(6),
+                      "FixedMatrix 3x3 adjugate()");
+
+        constexpr FixedMatrix<4, 4> a4({2., 1., 0., 0., 1., 2., 1., 0.,
+                                        0., 1., 2., 1., 0., 0., 1., 2.});
+        static_assert(a4.det() == 5., "FixedMatrix 4x4 det()");
+        static_assert(a4.inverse() * a4 == FixedMatrix<4, 4>(),
+                      "FixedMatrix 4x4 inverse()");
+        constexpr FixedMatrix<2, 3> wide({1., 2., 3., 4., 5., 6.});
+        static_assert(wide * wide.transposed() ==
+                          FixedMatrix<2, 2>({14., 32., 32., 77.}),
+                      "FixedMatrix product");
+
+        auto dense = RandomMatrix(6, 6);
+        auto fixed = FixedMatrix<6, 6>::fromMatrix(dense);
+        ASSERT_TRUE_MSG(std::abs(fixed.det() - dense.det()) <=
+                        EPS * std::max(1., std::abs(dense.det())),
+                        "FixedMatrix elimination det()")
+        ASSERT_TRUE_MSG((fixed.inverse() * fixed).toMatrix() == Matrix(6, 6),
+                        "FixedMatrix Gauss-Jordan inverse()")
+        ASSERT_TRUE_MSG((fixed * fixed.transposed()).toMatrix() ==
+                        dense * dense.transposed(), "FixedMatrix product")
+        ASSERT_EXCEPTION_MSG((FixedMatrix<6, 6>::fromMatrix(RandomMatrix(6, 5))),
+                             task::SizeMismatchException,
+                             "FixedMatrix fromMatrix()")
+
+        // L * U with a unit lower L has det equal to U's diagonal product.
+        FixedMatrix<6, 6, int64_t> lower;
+        FixedMatrix<6, 6, int64_t> upper;
+        const int64_t diagonal[6] = {2, 3, -1, 5, 1, 2};
+        for (size_t i = 0; i < 6; ++i) {
+            upper[i][i] = diagonal[i];
+            for (size_t j = 0; j < i; ++j) {
+                lower[i][j] = int64_t(RandomUInt(6)) - 3;
+                upper[j][i] = int64_t(RandomUInt(6)) - 3;
+            }
+        }
+        auto product = lower * upper;
+        task::BasicMatrix<int64_t> product_dense = product.toMatrix();
+        ASSERT_TRUE_MSG(product.det() == -60 && product_dense.det() == -60,
+                        "FixedMatrix Bareiss det()")
+
+        FixedMatrix<2, 2> singular2({1., 2., 2., 4.});
+        ASSERT_EXCEPTION_MSG(singular2.inverse(),
+                             task::SingularMatrixException,
+                             "FixedMatrix singular inverse()")
+        auto singular6 = fixed;
+        for (size_t j = 0; j < 6; ++j) {
+            singular6[5][j] = singular6[0][j];
+        }
+        ASSERT_TRUE_MSG(singular6.det() == 0. ||
+                        std::abs(singular6.det()) < EPS,
+                        "FixedMatrix singular det()")
+        ASSERT_EXCEPTION_MSG((FixedMatrix<5, 5>::zero().inverse()),
+                             task::SingularMatrixException,
+                             "FixedMatrix singular inverse()")
+        ASSERT_EXCEPTION_MSG(fixed.get(6, 0), task::OutOfBoundsException,
+                             "FixedMatrix get()")
+    }
+
+
+    {
+        using Fixed = task::FixedMatrix<3, 3>;
+        // Four blocks of kBlock matrices, so the work goes to the pool.
+        const size_t count = 1000;
+        task::MatrixBatch<3> lhs(count);
+        task::MatrixBatch<3> rhs(count);
+        for (size_t k = 0; k < count; ++k) {
+            Matrix a = RandomMatrix(3, 3) + Matrix(3, 3) * 30.;
+            lhs.set(k, Fixed::fromMatrix(a));
+            rhs.set(k, Fixed::fromMatrix(RandomMatrix(3, 3)));
+        }
+        auto product = lhs * rhs;
+        auto transposed = lhs.transposed();
+        auto inverse = lhs.inverse();
+        std::vector<double> det = lhs.det();
+        bool ok = product.size() == count && inverse.size() == count;
+        for (size_t k = 0; k < count; ++k) {
+            Fixed a = lhs.get(k);
+            Fixed b = rhs.get(k);
+            ok = ok && product.get(k) == a * b &&
+                 transposed.get(k) == a.transposed() &&
+                 inverse.get(k) == a.inverse() &&
+                 std::abs(det[k] - a.det()) <= EPS * std::abs(a.det());
+        }
+        ASSERT_TRUE_MSG(ok, "MatrixBatch operations")
+
+        auto aliased = lhs;
+        aliased.multiply(rhs, aliased);
+        ok = true;
+        for (size_t k = 0; k < count; ++k) {
+            ok = ok && aliased.get(k) == product.get(k);
+        }
+        aliased = lhs;
+        aliased.inverse(aliased);
+        for (size_t k = 0; k < count; ++k) {
+            ok = ok && aliased.get(k) == inverse.get(k);
+        }
+        aliased = lhs;
+        aliased.transpose(aliased);
+        for (size_t k = 0; k < count; ++k) {
+            ok = ok && aliased.get(k) == transposed.get(k);
+        }
+        ASSERT_TRUE_MSG(ok, "MatrixBatch output aliasing an operand")
+
+        lhs.set(count - 1, Fixed::zero());
+        ASSERT_EXCEPTION_MSG(lhs.inverse(), task::SingularMatrixException,
+                             "MatrixBatch singular inverse()")
+        ASSERT_EXCEPTION_MSG(lhs * task::MatrixBatch<3>(2),
+                             task::SizeMismatchException,
+                             "MatrixBatch size mismatch")
+        ASSERT_EXCEPTION_MSG(lhs.get(count), task::OutOfBoundsException,
+                             "MatrixBatch get()")
+
+        Fixed first = lhs.get(1);
+        lhs.resize(2);
+        lhs.resize(4);
+        ASSERT_TRUE_MSG(lhs.get(1) == first && lhs.get(3) == Fixed() &&
+                        lhs.size() == 4,
+                        "MatrixBatch resize()")
+
+        task::MatrixBatch<4> small(5);
+        task::FixedMatrix<4, 4> a4({2., 1., 0., 0., 1., 2., 1., 0.,
+                                    0., 1., 2., 1., 0., 0., 1., 2.});
+        small.set(2, a4);
+        ASSERT_TRUE_MSG(small.inverse().get(2) == a4.inverse() &&
+                        small.det()[2] == 5. && small.det()[0] == 1.,
+                        "MatrixBatch 4x4")
+    }
+
+
+    {
+        auto mat = RandomMatrix(20, 20);
+        auto expected = mat;
+        const double* buffer = static_cast<const Matrix&>(mat)[0];
+        Matrix moved(std::move(mat));
+        ASSERT_TRUE_MSG(mat.getRowSize() == 0 && mat.getColSize() == 0,
+                        "Moved-from matrix is empty")
+        ASSERT_TRUE_MSG(static_cast<const Matrix&>(moved)[0] == buffer &&
+                        moved == expected, "Move constructor")
+
+        Matrix assigned(3, 3);
+        assigned = std::move(moved);
+        ASSERT_TRUE_MSG(moved.getRowSize() == 0 && moved.getColSize() == 0,
+                        "Moved-from matrix is empty")
+        ASSERT_TRUE_MSG(static_cast<const Matrix&>(assigned)[0] == buffer &&
+                        assigned == expected, "Move assignment")
+
+        mat = RandomMatrix(4, 5);
+        moved.resize(2, 2);
+        moved[1][1] = 3.;
+        ASSERT_TRUE_MSG(mat.getRowSize() == 4 && moved.getRowSize() == 2 &&
+                        moved[1][1] == 3., "Moved-from matrix is reusable")
+
+        Matrix& alias = assigned;
+        assigned = std::move(alias);
+        ASSERT_TRUE_MSG(assigned == expected, "Self-move assignment")
+
+        auto small = RandomMatrix(2, 3);
+        auto small_expected = small;
+        Matrix small_moved(std::move(small));
+        ASSERT_TRUE_MSG(small_moved == small_expected &&
+                        small.getRowSize() == 0, "Move of an inline matrix")
+        small = std::move(small_moved);
+        ASSERT_TRUE_MSG(small == small_expected &&
+                        small_moved.getColSize() == 0,
+                        "Move of an inline matrix")
+    }
+
+
     const int STRESS_TEST_COUNT = argc > 1 ? std::stoi(argv[1]) : 0;
 
     REPEAT(STRESS_TEST_COUNT)